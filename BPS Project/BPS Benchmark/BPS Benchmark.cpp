@@ -0,0 +1,437 @@
+#include <iostream>
+
+#include "../BPS/BPSLib.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <new>
+#include <random>
+
+// every allocation of the process goes through these, so the library's allocations are counted too
+static std::atomic<std::size_t> allocation_count = 0;
+static std::atomic<std::size_t> allocated_bytes = 0;
+
+void* operator new(std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (auto p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+// shape of a generated corpus document
+struct corpus_options {
+	std::string name = "custom";
+	std::size_t keys = 1000;
+	// length of each string value
+	std::size_t string_length = 16;
+	// share of scalar values that are integers or doubles, the others are strings
+	double numeric_density = 0.5;
+	// share of keys holding an array
+	double array_density = 0.25;
+	// nesting levels of each array, and items on each level
+	std::size_t array_depth = 1;
+	std::size_t array_width = 8;
+	std::uint64_t seed = 1;
+};
+
+class corpus_generator {
+private:
+	const corpus_options& _options;
+	std::mt19937_64 _random;
+
+public:
+	corpus_generator(const corpus_options& options)
+		: _options(options), _random(options.seed) {
+	}
+
+	std::string generate() {
+		auto data = std::string();
+		char key[32];
+		for (auto k = std::size_t(0); k < _options.keys; ++k) {
+			std::snprintf(key, sizeof(key), "key%08zu", k);
+			data += key;
+			data += ':';
+			if (_options.array_depth > 0 and chance(_options.array_density)) {
+				write_array(_options.array_depth, data);
+			}
+			else {
+				write_scalar(data);
+			}
+			data += ";\n";
+		}
+		return data;
+	}
+
+private:
+	bool chance(double share) {
+		return std::uniform_real_distribution<double>(0, 1)(_random) < share;
+	}
+
+	void write_array(std::size_t depth, std::string& data) {
+		data += '[';
+		for (auto i = std::size_t(0); i < _options.array_width; ++i) {
+			if (i > 0) {
+				data += ',';
+			}
+			if (depth > 1) {
+				write_array(depth - 1, data);
+			}
+			else {
+				write_scalar(data);
+			}
+		}
+		data += ']';
+	}
+
+	void write_scalar(std::string& data) {
+		char number[64];
+		if (chance(_options.numeric_density)) {
+			if (chance(0.5)) {
+				auto n = std::uniform_int_distribution<long long>(-1000000, 1000000)(_random);
+				std::snprintf(number, sizeof(number), "%lld", n);
+			}
+			else {
+				auto n = std::uniform_real_distribution<double>(-1000, 1000)(_random);
+				std::snprintf(number, sizeof(number), "%.4f", n);
+			}
+			data += number;
+			return;
+		}
+
+		// printable chars without quotes or backslashes, so nothing needs escaping
+		static const char CHARS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-.:;,[]";
+		auto pick = std::uniform_int_distribution<std::size_t>(0, sizeof(CHARS) - 2);
+		data += '"';
+		for (auto i = std::size_t(0); i < _options.string_length; ++i) {
+			data += CHARS[pick(_random)];
+		}
+		data += '"';
+	}
+};
+
+struct measurement {
+	std::string corpus;
+	std::string operation;
+	std::size_t bytes = 0;
+	std::size_t iterations = 0;
+	double mb_per_second = 0;
+	double docs_per_second = 0;
+	double p50_us = 0;
+	double p90_us = 0;
+	double p99_us = 0;
+	double max_us = 0;
+	double allocations_per_doc = 0;
+	double allocated_bytes_per_doc = 0;
+};
+
+// one instrumented parse and plain of a corpus, its time split by phase
+struct phase_split {
+	std::string corpus;
+	bps_core::metrics metrics;
+};
+
+// runs operation once to warm up, then times each of the iterations, bytes is the text size one run handles
+template<class Operation>
+measurement measure(const std::string& corpus, const std::string& operation_name, std::size_t bytes, std::size_t iterations, Operation&& operation) {
+	operation();
+
+	auto latencies = std::vector<double>();
+	latencies.reserve(iterations);
+	auto allocations = allocation_count.load();
+	auto allocated = allocated_bytes.load();
+	auto total = 0.0;
+	for (auto i = std::size_t(0); i < iterations; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		operation();
+		auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+		latencies.push_back(elapsed);
+		total += elapsed;
+	}
+	allocations = allocation_count.load() - allocations;
+	allocated = allocated_bytes.load() - allocated;
+
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&](double p) {
+		return latencies[std::min(latencies.size() - 1, (std::size_t)(p * latencies.size()))];
+	};
+
+	auto result = measurement();
+	result.corpus = corpus;
+	result.operation = operation_name;
+	result.bytes = bytes;
+	result.iterations = iterations;
+	result.mb_per_second = (double)bytes * iterations / total;
+	result.docs_per_second = iterations / total * 1e6;
+	result.p50_us = percentile(0.5);
+	result.p90_us = percentile(0.9);
+	result.p99_us = percentile(0.99);
+	result.max_us = latencies.back();
+	// the latency vector was reserved before counting, only the operation allocates in the loop
+	result.allocations_per_doc = (double)allocations / iterations;
+	result.allocated_bytes_per_doc = (double)allocated / iterations;
+	return result;
+}
+
+// measures parse, plain and their round trip over a generated document, with both document models
+void run_corpus(const corpus_options& options, std::size_t iterations, std::vector<measurement>& results, std::vector<phase_split>& phases) {
+	auto data = corpus_generator(options).generate();
+	auto file = BPSLib::BPS::parse(data);
+	auto typed_file = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse(data, typed_file);
+	auto text = BPSLib::BPS::plain(file);
+
+	// results are kept alive past the timed call, so their destruction is measured too
+	auto sink = std::size_t(0);
+	results.push_back(measure(options.name, "parse", data.length(), iterations, [&]() {
+		sink += BPSLib::BPS::parse(data).size();
+	}));
+	results.push_back(measure(options.name, "plain", text.length(), iterations, [&]() {
+		sink += BPSLib::BPS::plain(file).length();
+	}));
+	results.push_back(measure(options.name, "round_trip", data.length(), iterations, [&]() {
+		sink += BPSLib::BPS::plain(BPSLib::BPS::parse(data)).length();
+	}));
+	results.push_back(measure(options.name, "parse_value", data.length(), iterations, [&]() {
+		BPSLib::BPS::parse(data, typed_file);
+		sink += typed_file.size();
+	}));
+	results.push_back(measure(options.name, "plain_value", text.length(), iterations, [&]() {
+		sink += BPSLib::BPS::plain(typed_file).length();
+	}));
+
+	if (sink == 0) {
+		std::cerr << "empty corpus " << options.name << std::endl;
+	}
+
+	auto& split = phases.emplace_back();
+	split.corpus = options.name;
+	auto instrumentation = bps_core::instrumentation();
+	instrumentation.counters = &split.metrics;
+	instrumentation.allocation_count = []() {
+		return (std::uint64_t)allocation_count.load();
+	};
+	BPSLib::BPS::instrument(&instrumentation);
+	sink += BPSLib::BPS::plain(BPSLib::BPS::parse(data)).length();
+	BPSLib::BPS::instrument(nullptr);
+}
+
+std::vector<corpus_options> default_corpora() {
+	auto corpora = std::vector<corpus_options>();
+
+	auto small = corpus_options();
+	small.name = "small";
+	small.keys = 16;
+	corpora.push_back(small);
+
+	auto strings = corpus_options();
+	strings.name = "strings";
+	strings.keys = 10000;
+	strings.string_length = 64;
+	strings.numeric_density = 0;
+	strings.array_density = 0;
+	corpora.push_back(strings);
+
+	auto numeric = corpus_options();
+	numeric.name = "numeric";
+	numeric.keys = 10000;
+	numeric.numeric_density = 1;
+	numeric.array_density = 0;
+	corpora.push_back(numeric);
+
+	auto nested = corpus_options();
+	nested.name = "nested";
+	nested.keys = 1000;
+	nested.numeric_density = 0.8;
+	nested.array_density = 1;
+	nested.array_depth = 3;
+	nested.array_width = 6;
+	corpora.push_back(nested);
+
+	auto mixed = corpus_options();
+	mixed.name = "mixed";
+	mixed.keys = 10000;
+	corpora.push_back(mixed);
+
+	return corpora;
+}
+
+// escapes the few chars a corpus name could hold
+std::string json_string(std::string_view v) {
+	auto result = std::string("\"");
+	for (auto c : v) {
+		if (c == '"' or c == '\\') {
+			result += '\\';
+		}
+		result += c;
+	}
+	return result + '"';
+}
+
+void write_json(const std::vector<corpus_options>& corpora, const std::vector<measurement>& results, const std::vector<phase_split>& phases, std::ostream& out) {
+	out << "{\n  \"corpora\": [\n";
+	for (auto i = std::size_t(0); i < corpora.size(); ++i) {
+		auto& c = corpora[i];
+		out << "    {\"name\": " << json_string(c.name) << ", \"keys\": " << c.keys << ", \"string_length\": " << c.string_length
+			<< ", \"numeric_density\": " << c.numeric_density << ", \"array_density\": " << c.array_density
+			<< ", \"array_depth\": " << c.array_depth << ", \"array_width\": " << c.array_width << ", \"seed\": " << c.seed << "}"
+			<< (i + 1 < corpora.size() ? ",\n" : "\n");
+	}
+	out << "  ],\n  \"results\": [\n";
+	for (auto i = std::size_t(0); i < results.size(); ++i) {
+		auto& r = results[i];
+		out << "    {\"corpus\": " << json_string(r.corpus) << ", \"operation\": " << json_string(r.operation)
+			<< ", \"bytes\": " << r.bytes << ", \"iterations\": " << r.iterations
+			<< ", \"mb_per_s\": " << r.mb_per_second << ", \"docs_per_s\": " << r.docs_per_second
+			<< ", \"p50_us\": " << r.p50_us << ", \"p90_us\": " << r.p90_us << ", \"p99_us\": " << r.p99_us << ", \"max_us\": " << r.max_us
+			<< ", \"allocations_per_doc\": " << r.allocations_per_doc << ", \"allocated_bytes_per_doc\": " << r.allocated_bytes_per_doc << "}"
+			<< (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	out << "  ],\n  \"phases\": [\n";
+	for (auto i = std::size_t(0); i < phases.size(); ++i) {
+		auto& m = phases[i].metrics;
+		auto tokens = std::uint64_t(0);
+		for (auto count : m.tokens) {
+			tokens += count;
+		}
+		out << "    {\"corpus\": " << json_string(phases[i].corpus)
+			<< ", \"lex_us\": " << m.lex_time.count() / 1000.0 << ", \"parse_us\": " << m.parse_time.count() / 1000.0
+			<< ", \"build_us\": " << m.build_time.count() / 1000.0 << ", \"serialize_us\": " << m.serialize_time.count() / 1000.0
+			<< ", \"tokens\": " << tokens << ", \"max_depth\": " << m.max_depth << ", \"allocations\": " << m.allocations << "}"
+			<< (i + 1 < phases.size() ? ",\n" : "\n");
+	}
+	out << "  ]\n}\n";
+}
+
+void write_table(const std::vector<measurement>& results, std::ostream& out) {
+	char line[256];
+	std::snprintf(line, sizeof(line), "%-10s %-12s %10s %10s %12s %10s %10s %10s %12s\n",
+		"corpus", "operation", "bytes", "MB/s", "docs/s", "p50 us", "p99 us", "max us", "allocs/doc");
+	out << line;
+	for (auto& r : results) {
+		std::snprintf(line, sizeof(line), "%-10s %-12s %10zu %10.1f %12.1f %10.1f %10.1f %10.1f %12.1f\n",
+			r.corpus.c_str(), r.operation.c_str(), r.bytes, r.mb_per_second, r.docs_per_second,
+			r.p50_us, r.p99_us, r.max_us, r.allocations_per_doc);
+		out << line;
+	}
+}
+
+void print_usage() {
+	std::cout << "usage: bps_benchmark [options]\n"
+		<< "  --iterations N        timed runs of each operation, default 50\n"
+		<< "  --output PATH         writes the results as JSON to PATH\n"
+		<< "  --corpus PATH         writes the generated corpus to PATH and exits\n"
+		<< "  --keys N              runs a single corpus with N keys instead of the default ones\n"
+		<< "  --string-length N     length of each string value\n"
+		<< "  --numeric-density F   share of scalar values that are numbers, from 0 to 1\n"
+		<< "  --array-density F     share of keys holding an array, from 0 to 1\n"
+		<< "  --array-depth N       nesting levels of each array\n"
+		<< "  --array-width N       items on each array level\n"
+		<< "  --seed N              seed of the corpus generator\n";
+}
+
+int main(int argc, char* argv[]) {
+	auto iterations = std::size_t(50);
+	auto output_path = std::string();
+	auto corpus_path = std::string();
+	auto custom = corpus_options();
+	auto use_custom = false;
+
+	for (auto i = 1; i < argc; ++i) {
+		auto arg = std::string_view(argv[i]);
+		if (arg == "--help") {
+			print_usage();
+			return 0;
+		}
+		if (i + 1 >= argc) {
+			std::cerr << "missing value of " << arg << std::endl;
+			return 2;
+		}
+		auto value = std::string(argv[++i]);
+		if (arg == "--iterations") {
+			iterations = std::max<std::size_t>(1, std::stoull(value));
+		}
+		else if (arg == "--output") {
+			output_path = value;
+		}
+		else if (arg == "--corpus") {
+			corpus_path = value;
+			use_custom = true;
+		}
+		else {
+			use_custom = true;
+			if (arg == "--keys") {
+				custom.keys = std::stoull(value);
+			}
+			else if (arg == "--string-length") {
+				custom.string_length = std::stoull(value);
+			}
+			else if (arg == "--numeric-density") {
+				custom.numeric_density = std::stod(value);
+			}
+			else if (arg == "--array-density") {
+				custom.array_density = std::stod(value);
+			}
+			else if (arg == "--array-depth") {
+				custom.array_depth = std::stoull(value);
+			}
+			else if (arg == "--array-width") {
+				custom.array_width = std::stoull(value);
+			}
+			else if (arg == "--seed") {
+				custom.seed = std::stoull(value);
+			}
+			else {
+				std::cerr << "unknown option " << arg << std::endl;
+				print_usage();
+				return 2;
+			}
+		}
+	}
+
+	if (!corpus_path.empty()) {
+		auto file = std::ofstream(corpus_path, std::ios::binary);
+		file << corpus_generator(custom).generate();
+		return file ? 0 : 1;
+	}
+
+	auto corpora = use_custom ? std::vector<corpus_options>{ custom } : default_corpora();
+	auto results = std::vector<measurement>();
+	auto phases = std::vector<phase_split>();
+	for (auto& corpus : corpora) {
+		run_corpus(corpus, iterations, results, phases);
+	}
+
+	write_table(results, std::cout);
+	if (!output_path.empty()) {
+		auto file = std::ofstream(output_path);
+		write_json(corpora, results, phases, file);
+		if (!file) {
+			std::cerr << "could not write " << output_path << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <fstream>
 
 #include "../BPS/BPSLib.hpp"
 
@@ -16,48 +17,70 @@ struct is_array<T[N]> {
 	using ElementType = T;
 };
 
-void print_value(const std::any& value) {
-	//auto valueType = value.type().name();
+struct bound_sample {
+	std::string name;
+	int count = 0;
+	float ratio = 0;
+	double weight = 0;
+	char grade = ' ';
+	bool active = false;
+	std::vector<int> ids;
+	std::vector<std::vector<double>> grid;
+};
+
+BPS_SCHEMA(bound_sample,
+	BPS_FIELD(name, "name"), BPS_FIELD(count, "count"), BPS_FIELD(ratio, "ratio"), BPS_FIELD(weight, "weight"),
+	BPS_FIELD(grade, "grade"), BPS_FIELD(active, "active"), BPS_FIELD(ids, "ids"), BPS_FIELD(grid, "grid"));
+
+// the keys of a flat document are found by their hash, so they can not be changed through its iterators
+static_assert(std::is_const_v<std::remove_reference_t<decltype(*std::declval<bps_core::flat_map<bps_core::value>&>().begin())>>);
 
-	if (value.type() == typeid(nullptr)) {
+void print_value(const bps_core::value& value) {
+	switch (value.type()) {
+	case bps_core::value_type::V_NULL:
 		std::cout << "null";
-	}
-	else if (value.type() == typeid(std::string)) {
-		std::cout << std::any_cast<std::string>(value);
-	}
-	else if (value.type() == typeid(bool)) {
-		std::cout << std::any_cast<bool>(value);
-	}
-	else if (value.type() == typeid(char)) {
-		std::cout << std::any_cast<char>(value);
-	}
-	else if (value.type() == typeid(int)) {
-		std::cout << std::any_cast<int>(value);
-	}
-	else if (value.type() == typeid(float)) {
-		std::cout << std::any_cast<float>(value);
-	}
-	else if (value.type() == typeid(double)) {
-		std::cout << std::any_cast<double>(value);
-	}
-	else if (value.type() == typeid(std::vector<std::any>)) {
+		break;
+	case bps_core::value_type::V_STRING:
+		std::cout << value.as_string();
+		break;
+	case bps_core::value_type::V_BOOL:
+		std::cout << value.as_bool();
+		break;
+	case bps_core::value_type::V_CHAR:
+		std::cout << value.as_char();
+		break;
+	case bps_core::value_type::V_INT:
+		std::cout << value.as_int();
+		break;
+	case bps_core::value_type::V_FLOAT:
+		std::cout << value.as_float();
+		break;
+	case bps_core::value_type::V_DOUBLE:
+		std::cout << value.as_double();
+		break;
+	case bps_core::value_type::V_ARRAY: {
 		std::cout << '[';
-		auto vec_value = std::any_cast<std::vector<std::any>>(value);
-		for (auto i = 0; i < vec_value.size(); ++i) {
+		auto& vec_value = value.as_array();
+		for (auto i = std::size_t(0); i < vec_value.size(); ++i) {
 			print_value(vec_value[i]);
 			if (i < vec_value.size() - 1) {
 				std::cout << ',';
 			}
 		}
 		std::cout << ']';
+		break;
+	}
+	case bps_core::value_type::V_TYPED_ARRAY:
+		print_value(bps_core::value(value.as_typed_array().to_array()));
+		break;
 	}
 }
 
-void print_map(const std::map<std::string, std::any> map) {
+void print_map(const std::map<std::string, bps_core::value>& map) {
 
 	for (auto& pair : map) {
 		const std::string& key = pair.first;
-		const std::any& value = pair.second;
+		const bps_core::value& value = pair.second;
 		std::cout << key << ":";
 		print_value(value);
 		std::cout << ";" << std::endl;
@@ -65,6 +88,633 @@ void print_map(const std::map<std::string, std::any> map) {
 
 }
 
+// parses data with every float mode and checks the plain text is the same as the long double one
+bool check_round_trip(const std::string& data) {
+	auto expected = BPSLib::BPS::plain(BPSLib::BPS::parse(data));
+	auto modes = { bps_core::float_mode::F_LONG_DOUBLE, bps_core::float_mode::F_DOUBLE, bps_core::float_mode::F_NATIVE };
+
+	// whatever parses must also validate, as well as what it is written back as
+	auto success = true;
+	if (!BPSLib::BPS::validate(data) or !BPSLib::BPS::validate(expected)) {
+		std::cout << "validation failed" << std::endl;
+		success = false;
+	}
+
+	// the document builder driven as a handler builds the same document
+	auto builder = bps_core::any_builder();
+	builder.reset();
+	BPSLib::BPS::parse(data, builder);
+	if (BPSLib::BPS::plain(builder.take()) != expected) {
+		std::cout << "handler round trip failed" << std::endl;
+		success = false;
+	}
+
+	// the streaming writer formats the values as plain does
+	auto streamed = std::string();
+	{
+		auto sink = bps_core::callback_sink([&](std::string_view chars) { streamed += chars; });
+		auto writer = bps_core::writer(sink, 64);
+		for (auto& entry : BPSLib::BPS::parse(data)) {
+			writer.key(entry.first).value(entry.second);
+		}
+	}
+	if (streamed != expected) {
+		std::cout << "writer round trip failed" << std::endl;
+		success = false;
+	}
+
+	// extracting every key reads the same values as the full parse
+	auto parsed = BPSLib::BPS::parse(data);
+	auto keys = std::vector<std::string_view>();
+	for (auto& entry : parsed) {
+		keys.push_back(entry.first);
+	}
+	if (BPSLib::BPS::plain(BPSLib::BPS::extract(data, keys)) != expected) {
+		std::cout << "extract round trip failed" << std::endl;
+		success = false;
+	}
+
+	// the lazy document parses each value on its own as it is read
+	auto lazy = bps_core::lazy_document();
+	lazy.load(data);
+	if (BPSLib::BPS::plain(lazy.to_map()) != expected) {
+		std::cout << "lazy round trip failed" << std::endl;
+		success = false;
+	}
+
+	// the same data twice, as two records separated by a blank line
+	auto records = data + "\n\n" + data;
+	auto reader = bps_core::record_reader();
+	reader.load(records);
+	auto count = 0;
+	for (auto& record : reader) {
+		success = BPSLib::BPS::plain(record) == expected and success;
+		++count;
+	}
+	if (count != 2 or !success) {
+		std::cout << "record round trip failed" << std::endl;
+		success = false;
+	}
+
+	for (auto mode : modes) {
+		auto options = bps_core::parse_options();
+		options.floats = mode;
+
+		auto any_plain = BPSLib::BPS::plain(BPSLib::BPS::parse(data, options));
+		auto typed_data = std::map<std::string, bps_core::value>();
+		BPSLib::BPS::parse(data, typed_data, options);
+		auto typed_plain = BPSLib::BPS::plain(typed_data);
+		auto flat_data = bps_core::flat_map<bps_core::value>();
+		BPSLib::BPS::parse(data, flat_data, options);
+		auto flat_plain = BPSLib::BPS::plain(flat_data);
+
+		// the plain text must also parse back to itself
+		auto reparsed_plain = BPSLib::BPS::plain(BPSLib::BPS::parse(typed_plain, options));
+
+		if (any_plain != expected or typed_plain != expected or flat_plain != expected or reparsed_plain != expected) {
+			std::cout << "round trip failed with float mode " << mode << std::endl;
+			success = false;
+		}
+
+		// packed arrays are written back the same as the arrays they were packed from
+		options.typed_arrays = true;
+		auto packed_any_plain = BPSLib::BPS::plain(BPSLib::BPS::parse(data, options));
+		auto packed_data = std::map<std::string, bps_core::value>();
+		BPSLib::BPS::parse(data, packed_data, options);
+		auto packed_plain = BPSLib::BPS::plain(packed_data);
+		auto packed_flat_data = bps_core::flat_map<std::any>();
+		BPSLib::BPS::parse(data, packed_flat_data, options, bps_core::key_order::K_SORTED);
+		auto packed_flat_plain = BPSLib::BPS::plain(packed_flat_data);
+
+		if (packed_any_plain != expected or packed_plain != expected or packed_flat_plain != expected) {
+			std::cout << "typed array round trip failed with float mode " << mode << std::endl;
+			success = false;
+		}
+	}
+	return success;
+}
+
+// whether parsing data into a bound_sample throws std::invalid_argument
+bool bind_fails(const std::string& data) {
+	auto sample = bound_sample();
+	try {
+		BPSLib::BPS::parse(data, sample);
+	}
+	catch (const std::invalid_argument&) {
+		return true;
+	}
+	return false;
+}
+
+// binds a struct, writes it back and binds it again, then checks the values that do not fit their fields
+bool check_bind() {
+	auto data = std::string("name:\"bound\";count:-42;ratio:0.5f;weight:2.25;grade:'b';active:true;ids:[1,2,3];grid:[[1.5,2],[]];extra:[1];");
+	auto sample = bound_sample();
+	BPSLib::BPS::parse(data, sample);
+
+	auto success = sample.name == "bound" and sample.count == -42 and sample.ratio == 0.5f and sample.weight == 2.25
+		and sample.grade == 'b' and sample.active and sample.ids == std::vector<int>{ 1, 2, 3 }
+		and sample.grid == std::vector<std::vector<double>>{ { 1.5, 2 }, {} };
+
+	auto text = BPSLib::BPS::plain(sample);
+	auto reparsed = bound_sample();
+	BPSLib::BPS::parse(text, reparsed);
+	success = success and BPSLib::BPS::plain(reparsed) == text;
+
+	// values out of the range of their field, and of another type
+	auto nines = std::string(300, '9');
+	auto errors = std::vector<std::string>{
+		"count:3000000000;",
+		"ratio:" + nines + ".0;",
+		"ratio:-" + nines.substr(0, 50) + ".0;",
+		"ids:[1,-3000000000];",
+		"name:5;",
+		"count:\"5\";",
+		"ids:[1,\"2\"];"
+	};
+	for (auto& error : errors) {
+		if (!bind_fails(error)) {
+			std::cout << "bind did not reject " << error.substr(0, 40) << std::endl;
+			success = false;
+		}
+	}
+
+	if (!success) {
+		std::cout << "bind round trip failed" << std::endl;
+	}
+	return success;
+}
+
+// parses an input larger than the part size on many threads, with statement ends, comments and quotes
+// in strings, chars and comments, and checks it is split at statement ends and parsed as a single parse
+bool check_parallel() {
+	auto data = std::string();
+	for (auto i = 0; data.length() < 3 * bps_core::parallel_parser::MIN_PART_SIZE; ++i) {
+		auto key = "key" + std::to_string(i);
+		data += key + ":\"a;b#c\\\"d;\";";
+		data += key + "c:[';','#','\\'',[],[[]]]; # a comment; with 'quotes\" and ;\n";
+		data += key + "e:[" + std::to_string(i) + ",2.5,[true,null]];\n";
+	}
+
+	auto success = true;
+	auto ends = bps_core::split_statements(data, 4);
+	auto scanner = bps_core::statement_scanner();
+	auto begin = std::size_t(0);
+	for (auto end : ends) {
+		// each part but the last ends right after the last statement end it holds
+		auto scanned = scanner.scan(std::string_view(data).substr(begin, end - begin));
+		success = end > begin and (end == data.length() or scanned == end - begin) and success;
+		begin = end;
+	}
+	success = ends.size() == 4 and ends.back() == data.length() and success;
+	if (!success) {
+		std::cout << "split statements failed" << std::endl;
+	}
+
+	// empty arrays are not syntax errors, so the parts holding them are kept
+	auto part_parser = bps_core::parser();
+	part_parser.begin();
+	part_parser.parse_part("a:[];b:[[],[[]]];", 1, 1);
+	part_parser.end();
+	if (part_parser.recovered() or part_parser.stopped()) {
+		std::cout << "empty arrays were recovered from" << std::endl;
+		success = false;
+	}
+
+	auto expected = BPSLib::BPS::plain(BPSLib::BPS::parse(data));
+	auto typed_data = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse_parallel(data, typed_data, 4);
+	if (BPSLib::BPS::plain(BPSLib::BPS::parse_parallel(data, 4)) != expected or BPSLib::BPS::plain(typed_data) != expected) {
+		std::cout << "parallel parse failed" << std::endl;
+		success = false;
+	}
+
+	// a malformed statement in the last part is parsed again by a single parser
+	data += "bad:[1,;after:2;";
+	if (BPSLib::BPS::plain(BPSLib::BPS::parse_parallel(data, 4)) != BPSLib::BPS::plain(BPSLib::BPS::parse(data))) {
+		std::cout << "parallel parse of malformed input failed" << std::endl;
+		success = false;
+	}
+	return success;
+}
+
+// data converted to binary and read in place gives the document back, typed arrays included, and binary
+// data that is truncated or points out of itself is rejected
+bool check_binary(const std::string& data) {
+	auto options = bps_core::parse_options();
+	options.typed_arrays = true;
+	auto typed_data = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse(data, typed_data, options);
+	auto expected = BPSLib::BPS::plain(typed_data);
+
+	// a binary document is read in place from 8 byte aligned data
+	auto binary = BPSLib::BPS::binary(typed_data);
+	auto buffer = std::vector<std::uint64_t>((binary.length() + 7) / 8);
+	std::memcpy(buffer.data(), binary.data(), binary.length());
+	auto bytes = std::string_view(reinterpret_cast<const char*>(buffer.data()), binary.length());
+
+	auto success = true;
+	auto document = bps_core::binary_document();
+	try {
+		document.load(bytes);
+		document.verify();
+		success = BPSLib::BPS::plain(document.to_map()) == expected and BPSLib::BPS::plain(document.to_any_map()) == expected
+			and BPSLib::BPS::binary(BPSLib::BPS::parse(data)) == binary;
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		success = false;
+	}
+	if (!success) {
+		std::cout << "binary round trip failed" << std::endl;
+		return false;
+	}
+
+	// a truncated document fails to load
+	try {
+		document.load(bytes.substr(0, bytes.length() / 2));
+		std::cout << "truncated binary was loaded" << std::endl;
+		success = false;
+	}
+	catch (const std::invalid_argument&) {
+	}
+
+	// a string or array whose size runs past the data loads, as only keys are checked, but fails to verify
+	document.load(bytes);
+	for (auto& entry : document.entries()) {
+		if (entry.value.type() == bps_core::value_type::V_STRING or entry.value.type() == bps_core::value_type::V_ARRAY) {
+			// the size follows the type, the item type and two reserved bytes
+			auto size = reinterpret_cast<const char*>(&entry.value) - bytes.data() + 4;
+			auto corrupt = std::uint32_t(0x7fffffff);
+			std::memcpy(reinterpret_cast<char*>(buffer.data()) + size, &corrupt, sizeof(corrupt));
+			break;
+		}
+	}
+	try {
+		document.load(bytes);
+		document.verify();
+		std::cout << "corrupt binary was verified" << std::endl;
+		success = false;
+	}
+	catch (const std::invalid_argument&) {
+	}
+	return success;
+}
+
+// text written back from a source document with the given edits
+std::string source_result(const std::string& source, const std::function<void(bps_core::source_document&)>& edit) {
+	auto document = bps_core::source_document();
+	document.load(source);
+	edit(document);
+	return BPSLib::BPS::plain(document);
+}
+
+// edits of a source document are spliced into the text it was loaded from, keeping comments, whitespace
+// and the order of the statements, and a document left unchanged is written back as it was loaded
+bool check_source() {
+	auto source = std::string();
+	source += "# settings\n";
+	source += "name : \"old\" ; # trailing\n";
+	source += "\n";
+	source += "port:80;\n";
+	source += "  legacy:true; # gone\n";
+	source += "list:[1, 2,\n  3];\n";
+	source += "name:\"duplicate\";\n";
+	source += "# end\n";
+
+	auto set = std::string();
+	set += "# settings\n";
+	set += "name : \"new\" ; # trailing\n";
+	set += "\n";
+	set += "port:80;\n";
+	set += "  legacy:true; # gone\n";
+	set += "list:[4];\n";
+	set += "name:\"duplicate\";\n";
+	set += "# end\n";
+
+	// erasing a key removes its duplicates as well
+	auto erased = std::string();
+	erased += "# settings\n";
+	erased += "# trailing\n";
+	erased += "\n";
+	erased += "port:80;\n";
+	erased += "  # gone\n";
+	erased += "list:[1, 2,\n  3];\n";
+	erased += "# end\n";
+
+	auto inserted = source + "added:5;\nflag:true;\n";
+
+	auto success = true;
+	if (source_result(source, [](bps_core::source_document&) {}) != source) {
+		std::cout << "unchanged source write failed" << std::endl;
+		success = false;
+	}
+	auto set_result = source_result(source, [](bps_core::source_document& document) {
+		document.set("name", bps_core::value(std::string("new")));
+		document.set("list", std::any(std::vector<std::any>{ 4LL }));
+	});
+	if (set_result != set) {
+		std::cout << "source set failed" << std::endl;
+		success = false;
+	}
+	auto erase_result = source_result(source, [](bps_core::source_document& document) {
+		document.erase("legacy");
+		document.erase("name");
+	});
+	if (erase_result != erased) {
+		std::cout << "source erase failed" << std::endl;
+		success = false;
+	}
+	auto insert_result = source_result(source, [](bps_core::source_document& document) {
+		document.set("added", bps_core::value(5LL));
+		document.set("flag", bps_core::value(true));
+	});
+	if (insert_result != inserted) {
+		std::cout << "source insert failed" << std::endl;
+		success = false;
+	}
+	return success;
+}
+
+// inputs parsed as a batch give what each gives parsed on its own, and an input that fails to parse makes
+// the batch throw its error
+bool check_batch(const std::vector<std::string>& inputs) {
+	auto success = true;
+	auto documents = BPSLib::BPS::parse_batch(inputs, 3);
+	success = documents.size() == inputs.size();
+	for (auto i = std::size_t(0); success and i < inputs.size(); ++i) {
+		success = BPSLib::BPS::plain(documents[i]) == BPSLib::BPS::plain(BPSLib::BPS::parse(inputs[i]));
+	}
+	if (!success) {
+		std::cout << "batch parse failed" << std::endl;
+	}
+
+	auto failing = inputs;
+	failing.insert(failing.begin() + failing.size() / 2, "a:1;b:@;");
+	auto expected = std::string();
+	try {
+		BPSLib::BPS::parse("a:1;b:@;");
+	}
+	catch (const std::exception& e) {
+		expected = e.what();
+	}
+	try {
+		BPSLib::BPS::parse_batch(failing, 3);
+		std::cout << "batch parse of a failing input did not throw" << std::endl;
+		success = false;
+	}
+	catch (const std::exception& e) {
+		if (expected.empty() or e.what() != expected) {
+			std::cout << "batch parse of a failing input failed: " << e.what() << std::endl;
+			success = false;
+		}
+	}
+	return success;
+}
+
+// handler writing the keys and strings it is given, parsing again the strings of the key "nested"
+struct nesting_handler {
+	std::string events;
+	std::string key;
+
+	void on_key(std::string_view k) {
+		key = k;
+		events += std::string(k) + ":";
+	}
+
+	void on_string(std::string_view v) {
+		if (key == "nested") {
+			auto inner = nesting_handler();
+			BPSLib::BPS::parse(v, inner);
+			events += "{" + inner.events + "}";
+		}
+		else {
+			events += std::string(v) + ";";
+		}
+	}
+};
+
+// a handler parsing from its events must not break the parse it is called from
+bool check_nested_handler() {
+	auto handler = nesting_handler();
+	BPSLib::BPS::parse("a:\"x\";nested:\"b:\\\"y\\\";c:\\\"z\\\";\";d:\"w\";", handler);
+	if (handler.events != "a:x;nested:{b:y;c:z;}d:w;") {
+		std::cout << "nested handler parse failed: " << handler.events << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// an arena document holds the values a parse gives, sorted by key, and its stats count its arena
+bool check_arena(const std::string& data) {
+	auto expected = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse(data, expected);
+
+	auto document = bps_core::arena_document();
+	BPSLib::BPS::parse(data, document);
+	auto copied = std::map<std::string, bps_core::value>();
+	for (auto& entry : document.entries()) {
+		copied.emplace_hint(copied.end(), entry.key, entry.value.to_value());
+	}
+
+	auto success = document.size() == expected.size() and BPSLib::BPS::plain(copied) == BPSLib::BPS::plain(expected);
+	for (auto& entry : expected) {
+		auto value = document.find(entry.first);
+		success = value and value->to_value() == entry.second and success;
+	}
+	if (!success) {
+		std::cout << "arena round trip failed" << std::endl;
+	}
+
+	auto& stats = document.stats();
+	if (stats.allocations == 0 or stats.used_bytes == 0 or stats.used_bytes > stats.reserved_bytes) {
+		std::cout << "arena stats failed" << std::endl;
+		success = false;
+	}
+	return success;
+}
+
+// documents parsed through one pool share the storage of their keys and short strings, and find their
+// values by the handles of the pool, scanning small documents and searching large ones
+bool check_intern() {
+	auto pool = bps_core::intern_pool(8);
+	auto first = bps_core::arena_document();
+	auto second = bps_core::arena_document();
+	BPSLib::BPS::parse("id:1;name:\"short\";text:\"a longer string\";", first, pool);
+	BPSLib::BPS::parse("text:\"a longer string\";name:\"short\";id:2;", second, pool);
+
+	auto success = first.size() == 3 and second.size() == 3;
+	for (auto i = std::size_t(0); success and i < first.size(); ++i) {
+		auto& a = first.entries()[i];
+		auto& b = second.entries()[i];
+		auto handle = pool.find(a.key);
+		success = a.key.data() == b.key.data() and handle and handle.view().data() == a.key.data()
+			and first.find(handle) == &a.value and second.find(handle) == &b.value;
+	}
+	// strings up to the pool max value length are interned, longer ones are stored in each document
+	success = success and first.at("name").as_string().data() == second.at("name").as_string().data()
+		and first.at("text").as_string().data() != second.at("text").as_string().data()
+		and first.at("id").as_int() == 1 and second.at("id").as_int() == 2;
+
+	auto data = std::string();
+	for (auto i = 0; i < 3 * (int)bps_core::arena_document::LINEAR_FIND_SIZE; ++i) {
+		data += "key" + std::to_string(i) + ":" + std::to_string(i) + ";";
+	}
+	auto large = bps_core::arena_document();
+	BPSLib::BPS::parse(data, large, pool);
+	for (auto i = 0; success and i < 3 * (int)bps_core::arena_document::LINEAR_FIND_SIZE; ++i) {
+		auto value = large.find(pool.find("key" + std::to_string(i)));
+		success = value and value->as_int() == i;
+	}
+
+	// a document parsed without the pool holds none of its keys
+	auto unpooled = bps_core::arena_document();
+	BPSLib::BPS::parse(data, unpooled);
+	success = success and !unpooled.find(pool.find("key0")) and !large.find(bps_core::interned());
+	if (!success) {
+		std::cout << "interned keys failed" << std::endl;
+	}
+	return success;
+}
+
+// each instrumented call reports its phases and advances the counters, whichever document, struct or
+// handler it parses to, and nothing is reported once the instrumentation is removed
+bool check_instrument(const std::string& data) {
+	auto totals = bps_core::metrics();
+	auto calls = 0;
+	auto instrumentation = bps_core::instrumentation();
+	instrumentation.counters = &totals;
+	instrumentation.callback = [&](const bps_core::metrics&) { ++calls; };
+	BPSLib::BPS::instrument(&instrumentation);
+
+	auto success = true;
+	auto output = BPSLib::BPS::plain(BPSLib::BPS::parse(data));
+	success = totals.documents == 2 and calls == 2 and totals.bytes_read == data.length()
+		and totals.bytes_written == output.length() and totals.max_depth == 3 and totals.tokens[bps_core::T_KEY] == 16
+		and totals.lex_time.count() > 0 and totals.parse_time.count() > 0 and totals.build_time.count() > 0
+		and totals.serialize_time.count() > 0;
+	if (!success) {
+		std::cout << "instrumented parse and plain failed" << std::endl;
+	}
+
+	auto builder = bps_core::any_builder();
+	builder.reset();
+	BPSLib::BPS::parse(data, builder);
+	auto sample = bound_sample();
+	BPSLib::BPS::parse("name:\"a\";count:1;", sample);
+	auto stream = std::istringstream(data);
+	BPSLib::BPS::parse(stream, 16);
+	if (totals.documents != 5 or totals.bytes_read != 3 * data.length() + 17) {
+		std::cout << "instrumented handler, bind and stream parses failed" << std::endl;
+		success = false;
+	}
+
+	BPSLib::BPS::instrument(nullptr);
+	BPSLib::BPS::parse(data);
+	BPSLib::BPS::parse(data, builder);
+	if (totals.documents != 5 or calls != 5) {
+		std::cout << "parse reported without instrumentation" << std::endl;
+		success = false;
+	}
+	return success;
+}
+
+// a file parsed in place gives what a parse of its text gives, an empty file gives an empty document and
+// a missing file throws
+bool check_parse_file(const std::string& data) {
+	auto path = std::filesystem::temp_directory_path() / "bps_tester.bps";
+	auto expected = BPSLib::BPS::plain(BPSLib::BPS::parse(data));
+
+	auto success = true;
+	try {
+		{
+			auto file = std::ofstream(path, std::ios::binary);
+			file << data;
+		}
+		auto typed_data = std::map<std::string, bps_core::value>();
+		BPSLib::BPS::parse_file(path, typed_data);
+		auto arena_data = bps_core::arena_document();
+		BPSLib::BPS::parse_file(path, arena_data);
+		auto arena_copy = std::map<std::string, bps_core::value>();
+		for (auto& entry : arena_data.entries()) {
+			arena_copy.emplace_hint(arena_copy.end(), entry.key, entry.value.to_value());
+		}
+		success = BPSLib::BPS::plain(BPSLib::BPS::parse_file(path)) == expected and BPSLib::BPS::plain(typed_data) == expected
+			and BPSLib::BPS::plain(arena_copy) == expected;
+
+		{
+			auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		}
+		BPSLib::BPS::parse_file(path, typed_data);
+		success = BPSLib::BPS::parse_file(path).empty() and typed_data.empty() and success;
+	}
+	catch (const std::exception& e) {
+		std::cout << e.what() << std::endl;
+		success = false;
+	}
+	std::filesystem::remove(path);
+	if (!success) {
+		std::cout << "file parse failed" << std::endl;
+	}
+
+	try {
+		BPSLib::BPS::parse_file(path);
+		std::cout << "parse of a missing file did not throw" << std::endl;
+		success = false;
+	}
+	catch (const std::system_error&) {
+	}
+	return success;
+}
+
+// extracting the keys of inputs the parser recovers from must give the values a parse gives
+bool check_extract_malformed() {
+	auto inputs = { "a:1;c:3", "a:1;b:[1,2;c:3;", "a:1;b 2;c:3;", "a:1;b:[1,,2];c:3;", "a:[];b:];c:3;" };
+
+	auto success = true;
+	for (auto input : inputs) {
+		auto expected = BPSLib::BPS::plain(BPSLib::BPS::parse(input));
+		if (BPSLib::BPS::plain(BPSLib::BPS::extract(input, { "a", "b", "c" })) != expected) {
+			std::cout << "extract of malformed input failed: " << input << std::endl;
+			success = false;
+		}
+	}
+	return success;
+}
+
+// plain text of the document, or the error message, of a parse of data pushed in chunks of the given size,
+// or of a single parse with a chunk size of 0
+std::string push_result(const std::string& data, std::size_t chunk_size) {
+	try {
+		if (chunk_size == 0) {
+			return BPSLib::BPS::plain(BPSLib::BPS::parse(data));
+		}
+		auto parser = bps_core::push_parser();
+		for (auto i = std::size_t(0); i < data.length(); i += chunk_size) {
+			parser.feed(std::string_view(data).substr(i, chunk_size));
+		}
+		return BPSLib::BPS::plain(parser.finish());
+	}
+	catch (const std::exception& e) {
+		return e.what();
+	}
+}
+
+// malformed inputs pushed one char at a time or in a single chunk must give what a single parse gives
+bool check_push_malformed() {
+	auto inputs = { "c;\"\"", "y;o['b'", "a:1;b:[2,;c:3;", "a:1;;b:2;", "a:'x;b:2;", "a:\"x;b:2;" };
+
+	auto success = true;
+	for (auto input : inputs) {
+		auto expected = push_result(input, 0);
+		if (push_result(input, 1) != expected or push_result(input, 4096) != expected) {
+			std::cout << "push parse of malformed input failed: " << input << std::endl;
+			success = false;
+		}
+	}
+	return success;
+}
+
 int main() {
 	//auto bpsStructData = BPS::parse("key1:\"value\";");
 	//std::string strData = std::any_cast<std::string>(bpsStructData["key1"]);
@@ -87,7 +737,8 @@ int main() {
 	data += "key14:[\"fal\\\"se\"];\n";
 	data += "key15:null;\n";
 	data += "key16:[[[1,0,0],[0,1,0],[0,0,1]],[[1,0,1],[0,1,0],[1,0,1]],[[0,0,1],[0,1,0],[1,0,0]]];\n";
-	auto bps_struct_data = BPSLib::BPS::parse(data);
+	auto bps_struct_data = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse(data, bps_struct_data);
 
 	print_map(bps_struct_data);
 
@@ -95,9 +746,32 @@ int main() {
 
 	std::cout << std::endl << bps_string_data;
 
-	auto bps_struct_data2 = BPSLib::BPS::parse(bps_string_data);
+	auto bps_struct_data2 = std::map<std::string, bps_core::value>();
+	BPSLib::BPS::parse(bps_string_data, bps_struct_data2);
 
 	std::cout << std::endl;
 
 	print_map(bps_struct_data2);
+
+	std::string numbers = "";
+	numbers += "int01:0;\n";
+	numbers += "int02:-9223372036854775807;\n";
+	numbers += "int03:9223372036854775807;\n";
+	numbers += "int04:42d;\n";
+	numbers += "flt01:0.1;\n";
+	numbers += "flt02:-2.5f;\n";
+	numbers += "flt03:3.14159F;\n";
+	numbers += "flt04:1234.5678d;\n";
+	numbers += "flt05:[0.5,1.25f,-7.75];\n";
+	numbers += "chr01:'\\\\';\n";
+	numbers += "chr02:'\\'';\n";
+
+	std::cout << std::endl;
+	auto success = check_round_trip(data) and check_round_trip(numbers) and check_push_malformed() and check_bind() and check_extract_malformed() and check_parallel() and check_binary(data) and check_binary(numbers) and check_source()
+		and check_batch({ data, numbers, "a:1;b:[1,;c:3;", "", data + numbers }) and check_nested_handler()
+		and check_arena(data) and check_arena(numbers) and check_intern() and check_instrument(data)
+		and check_parse_file(data) and check_parse_file(numbers);
+	std::cout << (success ? "round trip ok" : "round trip failed") << std::endl;
+
+	return success ? 0 : 1;
 }
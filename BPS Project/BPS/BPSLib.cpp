@@ -4,13 +4,250 @@
 
 namespace BPSLib {
 
-    std::map<std::string, std::any> BPS::parse(std::string data) {
-        auto parsedData = bps_core::parser::parse(data);
+    // each thread reuses its own contexts, so concurrent calls never share state
+    thread_local bps_core::parser _parser;
+    thread_local bps_core::value_parser _value_parser;
+    thread_local bps_core::flat_parser _flat_parser;
+    thread_local bps_core::flat_value_parser _flat_value_parser;
+    thread_local bps_core::arena_parser _arena_parser;
+    thread_local bps_core::parallel_parser _parallel_parser;
+    thread_local bps_core::value_parallel_parser _value_parallel_parser;
+    thread_local bps_core::plain _plain;
+    thread_local bps_core::binary _binary;
+    thread_local bps_core::validator _validator;
+    thread_local bps_core::extractor _extractor;
+    // instrumentation of the calls of this thread, for the parsers built per call or per type
+    thread_local const bps_core::instrumentation* _instrumentation = nullptr;
+
+    std::map<std::string, std::any> BPS::parse(std::string_view data) {
+        return parse(data, bps_core::parse_options());
+    }
+
+    std::map<std::string, std::any> BPS::parse(std::string_view data, const bps_core::parse_options& options) {
+        _parser.set_options(options);
+        auto parsedData = _parser.parse(data);
+        return parsedData;
+    }
+
+    void BPS::parse(std::string_view data, std::map<std::string, bps_core::value>& file) {
+        parse(data, file, bps_core::parse_options());
+    }
+
+    void BPS::parse(std::string_view data, std::map<std::string, bps_core::value>& file, const bps_core::parse_options& options) {
+        _value_parser.set_options(options);
+        file = _value_parser.parse(data);
+    }
+
+    void BPS::parse(std::string_view data, bps_core::flat_map<std::any>& file, bps_core::key_order order) {
+        parse(data, file, bps_core::parse_options(), order);
+    }
+
+    void BPS::parse(std::string_view data, bps_core::flat_map<std::any>& file, const bps_core::parse_options& options, bps_core::key_order order) {
+        _flat_parser.set_options(options);
+        file = _flat_parser.parse(data);
+        if (order == bps_core::key_order::K_SORTED) {
+            file.sort();
+        }
+    }
+
+    void BPS::parse(std::string_view data, bps_core::flat_map<bps_core::value>& file, bps_core::key_order order) {
+        parse(data, file, bps_core::parse_options(), order);
+    }
+
+    void BPS::parse(std::string_view data, bps_core::flat_map<bps_core::value>& file, const bps_core::parse_options& options, bps_core::key_order order) {
+        _flat_value_parser.set_options(options);
+        file = _flat_value_parser.parse(data);
+        if (order == bps_core::key_order::K_SORTED) {
+            file.sort();
+        }
+    }
+
+    void BPS::parse(std::string_view data, bps_core::arena_document& file) {
+        file = _arena_parser.parse(data);
+    }
+
+    void BPS::parse(std::string_view data, bps_core::arena_document& file, bps_core::intern_pool& pool) {
+        _arena_parser.builder().intern(&pool);
+        try {
+            file = _arena_parser.parse(data);
+        }
+        catch (...) {
+            _arena_parser.builder().intern(nullptr);
+            throw;
+        }
+        _arena_parser.builder().intern(nullptr);
+    }
+
+    std::map<std::string, std::any> BPS::parse(std::istream& input, std::size_t chunk_size) {
+        auto pushParser = bps_core::push_parser();
+        pushParser.set_instrumentation(_instrumentation);
+        auto chunk = std::string(std::max<std::size_t>(chunk_size, 1), '\0');
+
+        // each chunk is parsed before the next one is read
+        while (input.read(chunk.data(), chunk.size()) or input.gcount() > 0) {
+            pushParser.feed(std::string_view(chunk.data(), (std::size_t)input.gcount()));
+        }
+
+        return pushParser.finish();
+    }
+
+    std::map<std::string, std::any> BPS::parse_file(const std::filesystem::path& path) {
+        auto mapping = bps_core::mapped_file(path);
+        return parse(mapping.view());
+    }
+
+    void BPS::parse_file(const std::filesystem::path& path, std::map<std::string, bps_core::value>& file) {
+        auto mapping = bps_core::mapped_file(path);
+        parse(mapping.view(), file);
+    }
+
+    void BPS::parse_file(const std::filesystem::path& path, bps_core::arena_document& file) {
+        auto mapping = bps_core::mapped_file(path);
+        auto data = mapping.view();
+
+        _arena_parser.begin();
+        _arena_parser.builder().borrow(std::move(mapping));
+        try {
+            _arena_parser.parse_part(data, 1, 1);
+        }
+        catch (...) {
+            // unmaps the file now instead of on the next parse
+            _arena_parser.builder().reset();
+            throw;
+        }
+        file = _arena_parser.end();
+    }
+
+    void BPS::parse_file(const std::filesystem::path& path, bps_core::lazy_document& file) {
+        file.load(bps_core::mapped_file(path));
+    }
+
+    void BPS::parse_file(const std::filesystem::path& path, bps_core::binary_document& file) {
+        file.load(bps_core::mapped_file(path));
+    }
+
+    void BPS::parse_file(const std::filesystem::path& path, bps_core::source_document& file) {
+        // the document edits its own copy of the text, the file can be written over while it is open
+        auto data = bps_core::mapped_file(path);
+        file.load(std::string(data.view()));
+    }
+
+    std::map<std::string, std::any> BPS::extract(std::string_view data, std::initializer_list<std::string_view> paths) {
+        return extract(data, std::span<const std::string_view>(paths.begin(), paths.size()));
+    }
+
+    std::map<std::string, std::any> BPS::extract(std::string_view data, std::span<const std::string_view> paths) {
+        _extractor.set_paths(paths);
+        return _extractor.extract(data);
+    }
+
+    bps_core::validation_result BPS::validate(std::string_view data) {
+        return _validator.validate(data);
+    }
+
+    std::vector<std::map<std::string, std::any>> BPS::parse_batch(std::span<const std::string> data, unsigned int threads) {
+        auto parsedData = std::vector<std::map<std::string, std::any>>(data.size());
+
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = (unsigned int)std::min<size_t>(threads, data.size());
+
+        // workers pull the next input index until the span is exhausted, each with the parser of its thread
+        std::atomic<size_t> next = 0;
+        std::exception_ptr error = nullptr;
+        std::mutex errorMutex;
+
+        bps_core::run_workers(threads, [&](unsigned int) {
+            for (auto i = next++; i < data.size(); i = next++) {
+                try {
+                    parsedData[i] = _parser.parse(data[i]);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    next = data.size();
+                }
+            }
+        });
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
         return parsedData;
     }
 
-    std::string BPS::plain(std::map<std::string, std::any> data) {
-        return bps_core::plain::parse(data);
+    std::map<std::string, std::any> BPS::parse_parallel(std::string_view data, unsigned int threads) {
+        _parallel_parser.set_threads(threads);
+        return _parallel_parser.parse(data);
+    }
+
+    void BPS::parse_parallel(std::string_view data, std::map<std::string, bps_core::value>& file, unsigned int threads) {
+        _value_parallel_parser.set_threads(threads);
+        file = _value_parallel_parser.parse(data);
+    }
+
+    std::string BPS::plain(const std::map<std::string, std::any>& data) {
+        return _plain.parse(data);
+    }
+
+    std::string BPS::plain(const std::map<std::string, bps_core::value>& data) {
+        return _plain.parse(data);
+    }
+
+    std::string BPS::plain(const bps_core::flat_map<std::any>& data) {
+        return _plain.parse(data);
+    }
+
+    std::string BPS::plain(const bps_core::flat_map<bps_core::value>& data) {
+        return _plain.parse(data);
+    }
+
+    std::string BPS::plain(const bps_core::source_document& data) {
+        auto output = std::string();
+        data.write(output);
+        return output;
+    }
+
+    void BPS::plain(const std::map<std::string, std::any>& data, std::string& output) {
+        _plain.write(data, output);
+    }
+
+    void BPS::plain(const std::map<std::string, bps_core::value>& data, std::string& output) {
+        _plain.write(data, output);
+    }
+
+    std::string BPS::binary(const std::map<std::string, std::any>& data) {
+        return _binary.parse(data);
+    }
+
+    std::string BPS::binary(const std::map<std::string, bps_core::value>& data) {
+        return _binary.parse(data);
+    }
+
+    std::string BPS::binary(const bps_core::flat_map<std::any>& data) {
+        return _binary.parse(data);
+    }
+
+    std::string BPS::binary(const bps_core::flat_map<bps_core::value>& data) {
+        return _binary.parse(data);
+    }
+
+    void BPS::instrument(const bps_core::instrumentation* instrumentation) {
+        _instrumentation = instrumentation;
+        _parser.set_instrumentation(instrumentation);
+        _value_parser.set_instrumentation(instrumentation);
+        _flat_parser.set_instrumentation(instrumentation);
+        _flat_value_parser.set_instrumentation(instrumentation);
+        _arena_parser.set_instrumentation(instrumentation);
+        _plain.set_instrumentation(instrumentation);
+    }
+
+    const bps_core::instrumentation* BPS::current_instrumentation() {
+        return _instrumentation;
     }
 
-}
+}
\ No newline at end of file
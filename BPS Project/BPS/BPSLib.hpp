@@ -2,6 +2,18 @@
 
 #include "framework.h"
 #include "bps_core.hpp"
+#include "bps_arena.hpp"
+#include "bps_stream.hpp"
+#include "bps_lazy.hpp"
+#include "bps_source.hpp"
+#include "bps_records.hpp"
+#include "bps_parallel.hpp"
+#include "bps_binary.hpp"
+#include "bps_bind.hpp"
+#include "bps_events.hpp"
+#include "bps_extract.hpp"
+#include "bps_validate.hpp"
+#include "bps_writer.hpp"
 
 
 namespace BPSLib {
@@ -16,14 +28,361 @@ namespace BPSLib {
         /// </summary>
         /// <param name="data">BPS data in string format.</param>
         /// <returns>BPS file representation from data.</returns>
-        static std::map<std::string, std::any> parse(std::string data);
+        static std::map<std::string, std::any> parse(std::string_view data);
+
+        /// <summary>
+        /// Parse a string BPS data return a BPSFile, decoding its constants as the options tell.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="options">Parse options, like the type used to store floats.</param>
+        /// <returns>BPS file representation from data.</returns>
+        static std::map<std::string, std::any> parse(std::string_view data, const bps_core::parse_options& options);
+
+        /// <summary>
+        /// Parse a string BPS data into a typed BPS file.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Typed BPS file representation from data, replaced by the parsed data.</param>
+        static void parse(std::string_view data, std::map<std::string, bps_core::value>& file);
+
+        /// <summary>
+        /// Parse a string BPS data into a typed BPS file, decoding its constants as the options tell.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Typed BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="options">Parse options, like the type used to store floats.</param>
+        static void parse(std::string_view data, std::map<std::string, bps_core::value>& file, const bps_core::parse_options& options);
+
+        /// <summary>
+        /// Parse a string BPS data into a flat BPS file, whose keys are found through a hash table.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Flat BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="order">Order the file iterates its keys in, sorted as a std::map or as they appear in data.</param>
+        static void parse(std::string_view data, bps_core::flat_map<std::any>& file, bps_core::key_order order = bps_core::key_order::K_SORTED);
+
+        /// <summary>
+        /// Parse a string BPS data into a flat BPS file, whose keys are found through a hash table, decoding its constants as the options tell.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Flat BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="options">Parse options, like the type used to store floats.</param>
+        /// <param name="order">Order the file iterates its keys in, sorted as a std::map or as they appear in data.</param>
+        static void parse(std::string_view data, bps_core::flat_map<std::any>& file, const bps_core::parse_options& options, bps_core::key_order order = bps_core::key_order::K_SORTED);
+
+        /// <summary>
+        /// Parse a string BPS data into a flat typed BPS file, whose keys are found through a hash table.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Flat typed BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="order">Order the file iterates its keys in, sorted as a std::map or as they appear in data.</param>
+        static void parse(std::string_view data, bps_core::flat_map<bps_core::value>& file, bps_core::key_order order = bps_core::key_order::K_SORTED);
+
+        /// <summary>
+        /// Parse a string BPS data into a flat typed BPS file, whose keys are found through a hash table, decoding its constants as the options tell.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Flat typed BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="options">Parse options, like the type used to store floats.</param>
+        /// <param name="order">Order the file iterates its keys in, sorted as a std::map or as they appear in data.</param>
+        static void parse(std::string_view data, bps_core::flat_map<bps_core::value>& file, const bps_core::parse_options& options, bps_core::key_order order = bps_core::key_order::K_SORTED);
+
+        /// <summary>
+        /// Parse a string BPS data straight into the fields of a struct declared with BPS_SCHEMA.
+        /// Keys out of its schema are skipped and fields without key keep their default value.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="object">Struct the parsed data is written to, replaced by the parsed data.</param>
+        template<bps_core::bound T>
+        static void parse(std::string_view data, T& object);
+
+        /// <summary>
+        /// Parse a string BPS data into the events of a handler, without building a BPS file.
+        /// The handler methods are called directly, the events it does not declare are skipped.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="handler">Handler taking on_key and the value and array events, in the order they appear in data.</param>
+        template<bps_core::handler Handler>
+        static void parse(std::string_view data, Handler& handler);
+
+        /// <summary>
+        /// Parse a string BPS data into the events of a handler, without building a BPS file.
+        /// The handler methods are called directly, the events it does not declare are skipped.
+        /// A handler may parse other data from its events, which is then parsed by a parser of its own.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="handler">Handler taking on_key and the value and array events, in the order they appear in data.</param>
+        /// <param name="options">Parse options, whose float storage chooses the float event called.</param>
+        template<bps_core::handler Handler>
+        static void parse(std::string_view data, Handler& handler, const bps_core::parse_options& options);
+
+        /// <summary>
+        /// Parse a string BPS data into a BPS file held by a single arena.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Arena BPS file representation from data, replaced by the parsed data.</param>
+        static void parse(std::string_view data, bps_core::arena_document& file);
+
+        /// <summary>
+        /// Parse a string BPS data into an arena BPS file whose keys, and short strings, are interned in a pool shared
+        /// by many parses. Keys found again are not stored, and can be found by pointer with the handles of the pool.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Arena BPS file representation from data, replaced by the parsed data. The pool must outlive it.</param>
+        /// <param name="pool">Pool the keys, and the strings up to its max value length, are interned in.</param>
+        static void parse(std::string_view data, bps_core::arena_document& file, bps_core::intern_pool& pool);
+
+        /// <summary>
+        /// Parse a BPS data stream, reading and parsing it chunk by chunk so only the statement being read is buffered.
+        /// </summary>
+        /// <param name="input">Stream with BPS data, read until its end.</param>
+        /// <param name="chunk_size">Number of bytes read at a time.</param>
+        /// <returns>BPS file representation from the stream data.</returns>
+        static std::map<std::string, std::any> parse(std::istream& input, std::size_t chunk_size = 64 * 1024);
+
+        /// <summary>
+        /// Parse a BPS file straight from its memory mapped pages, without reading it into a string.
+        /// </summary>
+        /// <param name="path">Path of the BPS file.</param>
+        /// <returns>BPS file representation from the file data.</returns>
+        static std::map<std::string, std::any> parse_file(const std::filesystem::path& path);
+
+        /// <summary>
+        /// Parse a BPS file straight from its memory mapped pages into a typed BPS file.
+        /// </summary>
+        /// <param name="path">Path of the BPS file.</param>
+        /// <param name="file">Typed BPS file representation from the file data, replaced by the parsed data.</param>
+        static void parse_file(const std::filesystem::path& path, std::map<std::string, bps_core::value>& file);
+
+        /// <summary>
+        /// Parse a BPS file straight from its memory mapped pages into an arena BPS file.
+        /// Keys and strings without escape chars point into the mapping, which is held by the arena BPS file.
+        /// </summary>
+        /// <param name="path">Path of the BPS file.</param>
+        /// <param name="file">Arena BPS file representation from the file data, replaced by the parsed data.</param>
+        static void parse_file(const std::filesystem::path& path, bps_core::arena_document& file);
+
+        /// <summary>
+        /// Index a BPS file from its memory mapped pages, each value is parsed only the first time it is read.
+        /// </summary>
+        /// <param name="path">Path of the BPS file.</param>
+        /// <param name="file">Lazy BPS file indexing the file data, which it keeps mapped.</param>
+        static void parse_file(const std::filesystem::path& path, bps_core::lazy_document& file);
+
+        /// <summary>
+        /// Read a BPS binary file in place from its memory mapped pages, without decoding it.
+        /// </summary>
+        /// <param name="path">Path of the BPS binary file.</param>
+        /// <param name="file">Binary BPS file reading the file data, which it keeps mapped.</param>
+        static void parse_file(const std::filesystem::path& path, bps_core::binary_document& file);
+
+        /// <summary>
+        /// Read a BPS file into a source BPS file, which keeps its text so edits can be written back
+        /// without touching the rest of it.
+        /// </summary>
+        /// <param name="path">Path of the BPS file.</param>
+        /// <param name="file">Source BPS file holding the file text, replaced by the file data.</param>
+        static void parse_file(const std::filesystem::path& path, bps_core::source_document& file);
+
+        /// <summary>
+        /// Read only the values of some keys, or of array items as "key[1][0]", from a string BPS data.
+        /// The other values are skipped without being parsed and the data is read until every key was found.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="paths">Keys, each optionally followed by array indices.</param>
+        /// <returns>The values found, by path. Paths not found in data are left out.</returns>
+        static std::map<std::string, std::any> extract(std::string_view data, std::initializer_list<std::string_view> paths);
+
+        /// <summary>
+        /// Read only the values of some keys, or of array items as "key[1][0]", from a string BPS data.
+        /// The other values are skipped without being parsed and the data is read until every key was found.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="paths">Keys, each optionally followed by array indices.</param>
+        /// <returns>The values found, by path. Paths not found in data are left out.</returns>
+        static std::map<std::string, std::any> extract(std::string_view data, std::span<const std::string_view> paths);
+
+        /// <summary>
+        /// Check a string BPS data follows the BPS grammar without building its BPS file.
+        /// Values are only scanned, so numbers out of range are not reported.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <returns>Whether data is valid, with the line, collumn and message of its first error.</returns>
+        static bps_core::validation_result validate(std::string_view data);
+
+        /// <summary>
+        /// Parse many string BPS data in parallel, each worker thread reusing the parser of its thread.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="threads">Number of worker threads, 0 to use the hardware concurrency.</param>
+        /// <returns>BPS file representations, in the same order as data.</returns>
+        static std::vector<std::map<std::string, std::any>> parse_batch(std::span<const std::string> data, unsigned int threads = 0);
+
+        /// <summary>
+        /// Parse a single large string BPS data in parallel, split at its statement ends.
+        /// The first value of a duplicated key is kept, as in parse.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="threads">Number of worker threads, 0 to use the hardware concurrency.</param>
+        /// <returns>BPS file representation from data.</returns>
+        static std::map<std::string, std::any> parse_parallel(std::string_view data, unsigned int threads = 0);
+
+        /// <summary>
+        /// Parse a single large string BPS data in parallel into a typed BPS file, split at its statement ends.
+        /// </summary>
+        /// <param name="data">BPS data in string format.</param>
+        /// <param name="file">Typed BPS file representation from data, replaced by the parsed data.</param>
+        /// <param name="threads">Number of worker threads, 0 to use the hardware concurrency.</param>
+        static void parse_parallel(std::string_view data, std::map<std::string, bps_core::value>& file, unsigned int threads = 0);
 
         /// <summary>
         /// Convert a BPS structured data to plain text.
         /// </summary>
         /// <param name="data">BPS structured data to convert.</param>
         /// <returns>A String representation from data.</returns>
-        static std::string plain(std::map<std::string, std::any> data);
+        static std::string plain(const std::map<std::string, std::any>& data);
+
+        /// <summary>
+        /// Convert a typed BPS structured data to plain text.
+        /// </summary>
+        /// <param name="data">Typed BPS structured data to convert.</param>
+        /// <returns>A String representation from data.</returns>
+        static std::string plain(const std::map<std::string, bps_core::value>& data);
+
+        /// <summary>
+        /// Convert a flat BPS structured data to plain text, in the order it iterates its keys.
+        /// </summary>
+        /// <param name="data">Flat BPS structured data to convert.</param>
+        /// <returns>A String representation from data.</returns>
+        static std::string plain(const bps_core::flat_map<std::any>& data);
+
+        /// <summary>
+        /// Convert a flat typed BPS structured data to plain text, in the order it iterates its keys.
+        /// </summary>
+        /// <param name="data">Flat typed BPS structured data to convert.</param>
+        /// <returns>A String representation from data.</returns>
+        static std::string plain(const bps_core::flat_map<bps_core::value>& data);
+
+        /// <summary>
+        /// Convert the fields of a struct declared with BPS_SCHEMA to plain text, in the order of its schema.
+        /// </summary>
+        /// <param name="object">Struct to convert.</param>
+        /// <returns>A String representation from object.</returns>
+        template<bps_core::bound T>
+        static std::string plain(const T& object);
+
+        /// <summary>
+        /// Convert a source BPS file to plain text, its source with the edited values spliced in.
+        /// </summary>
+        /// <param name="data">Source BPS file to convert.</param>
+        /// <returns>A String representation from data.</returns>
+        static std::string plain(const bps_core::source_document& data);
+
+        /// <summary>
+        /// Convert a BPS structured data to plain text, appending it to output so its memory can be reused.
+        /// </summary>
+        /// <param name="data">BPS structured data to convert.</param>
+        /// <param name="output">String the representation from data is appended to.</param>
+        static void plain(const std::map<std::string, std::any>& data, std::string& output);
+
+        /// <summary>
+        /// Convert a typed BPS structured data to plain text, appending it to output so its memory can be reused.
+        /// </summary>
+        /// <param name="data">Typed BPS structured data to convert.</param>
+        /// <param name="output">String the representation from data is appended to.</param>
+        static void plain(const std::map<std::string, bps_core::value>& data, std::string& output);
+
+        /// <summary>
+        /// Convert a BPS structured data to BPS binary data, which can be read in place by a binary_document.
+        /// </summary>
+        /// <param name="data">BPS structured data to convert.</param>
+        /// <returns>The BPS binary representation from data.</returns>
+        static std::string binary(const std::map<std::string, std::any>& data);
+
+        /// <summary>
+        /// Convert a typed BPS structured data to BPS binary data, which can be read in place by a binary_document.
+        /// </summary>
+        /// <param name="data">Typed BPS structured data to convert.</param>
+        /// <returns>The BPS binary representation from data.</returns>
+        static std::string binary(const std::map<std::string, bps_core::value>& data);
+
+        /// <summary>
+        /// Convert a flat BPS structured data to BPS binary data, which can be read in place by a binary_document.
+        /// </summary>
+        /// <param name="data">Flat BPS structured data to convert.</param>
+        /// <returns>The BPS binary representation from data.</returns>
+        static std::string binary(const bps_core::flat_map<std::any>& data);
+
+        /// <summary>
+        /// Convert a flat typed BPS structured data to BPS binary data, which can be read in place by a binary_document.
+        /// </summary>
+        /// <param name="data">Flat typed BPS structured data to convert.</param>
+        /// <returns>The BPS binary representation from data.</returns>
+        static std::string binary(const bps_core::flat_map<bps_core::value>& data);
+
+        /// <summary>
+        /// Report the metrics of the parse and plain calls made by this thread, a call at a time, handler, bound and
+        /// stream parses included. Parsing of batches and parallel parsing run on other threads, whose metrics could not
+        /// be added to the counters of this thread, and are not reported. Neither are extract, validate and the documents
+        /// that load a file without parsing it, as lazy, binary and source documents do.
+        /// </summary>
+        /// <param name="instrumentation">Where the metrics are reported, it must outlive the calls. Nullptr stops reporting.</param>
+        static void instrument(const bps_core::instrumentation* instrumentation);
+
+    private:
+        /// <summary>
+        /// Instrumentation set by instrument() on this thread, nullptr if none.
+        /// </summary>
+        static const bps_core::instrumentation* current_instrumentation();
     };
 
-}
+    template<bps_core::bound T>
+    void BPS::parse(std::string_view data, T& object) {
+        // binding calls no user code, so the parser of the type is never parsing already
+        static thread_local bps_core::bind_parser<T> bindParser;
+        bindParser.set_instrumentation(current_instrumentation());
+        object = bindParser.parse(data);
+    }
+
+    template<bps_core::handler Handler>
+    void BPS::parse(std::string_view data, Handler& handler) {
+        parse(data, handler, bps_core::parse_options());
+    }
+
+    template<bps_core::handler Handler>
+    void BPS::parse(std::string_view data, Handler& handler, const bps_core::parse_options& options) {
+        static thread_local bps_core::event_parser<Handler> eventParser;
+        static thread_local bool parsing = false;
+
+        auto run = [&](bps_core::event_parser<Handler>& parser) {
+            parser.set_options(options);
+            parser.set_instrumentation(current_instrumentation());
+            parser.builder().bind(handler);
+            parser.parse(data);
+        };
+
+        // a handler parsing again from its events gets a parser of its own, the shared one being mid parse
+        if (parsing) {
+            auto nestedParser = bps_core::event_parser<Handler>();
+            run(nestedParser);
+            return;
+        }
+        parsing = true;
+        try {
+            run(eventParser);
+        }
+        catch (...) {
+            parsing = false;
+            throw;
+        }
+        parsing = false;
+    }
+
+    template<bps_core::bound T>
+    std::string BPS::plain(const T& object) {
+        auto output = std::string();
+        bps_core::write_bound(object, output);
+        return output;
+    }
+
+}
\ No newline at end of file
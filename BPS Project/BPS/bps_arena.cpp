@@ -0,0 +1,489 @@
+#include "pch.h"
+#include "bps_arena.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bps_core {
+
+	const std::size_t arena::MIN_CHUNK_SIZE = 64 * 1024;
+	const std::size_t arena::MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+	arena::arena(arena&& other) noexcept
+		: _head(other._head), _allocations(other._allocations), _reserved(other._reserved), _used(other._used) {
+		other._head = nullptr;
+		other._allocations = 0;
+		other._reserved = 0;
+		other._used = 0;
+	}
+
+	arena& arena::operator=(arena&& other) noexcept {
+		if (this != &other) {
+			release();
+			std::swap(_head, other._head);
+			std::swap(_allocations, other._allocations);
+			std::swap(_reserved, other._reserved);
+			std::swap(_used, other._used);
+		}
+		return *this;
+	}
+
+	arena::~arena() {
+		release();
+	}
+
+	void* arena::allocate(std::size_t size, std::size_t alignment) {
+		if (_head != nullptr) {
+			auto base = reinterpret_cast<std::uintptr_t>(_head + 1);
+			auto offset = (base + _head->used + alignment - 1) / alignment * alignment - base;
+			if (offset + size <= _head->size) {
+				_head->used = offset + size;
+				_used += size;
+				return reinterpret_cast<void*>(base + offset);
+			}
+		}
+
+		// chunks double in size, so a document needs only a logarithmic number of them
+		auto chunk_size = _head == nullptr ? MIN_CHUNK_SIZE : std::min(_head->size * 2, MAX_CHUNK_SIZE);
+		chunk_size = std::max(chunk_size, size + alignment);
+
+		auto next = static_cast<chunk*>(std::malloc(sizeof(chunk) + chunk_size));
+		if (next == nullptr) {
+			throw std::bad_alloc();
+		}
+		next->next = _head;
+		next->size = chunk_size;
+		next->used = 0;
+		_head = next;
+		++_allocations;
+		_reserved += chunk_size;
+
+		return allocate(size, alignment);
+	}
+
+	std::string_view arena::store(std::string_view str) {
+		if (str.empty()) {
+			return std::string_view();
+		}
+		auto data = static_cast<char*>(allocate(str.length(), 1));
+		std::memcpy(data, str.data(), str.length());
+		return std::string_view(data, str.length());
+	}
+
+	void arena::release() noexcept {
+		while (_head != nullptr) {
+			auto next = _head->next;
+			std::free(_head);
+			_head = next;
+		}
+		_allocations = 0;
+		_reserved = 0;
+		_used = 0;
+	}
+
+	std::size_t arena::allocations() const noexcept {
+		return _allocations;
+	}
+
+	std::size_t arena::reserved() const noexcept {
+		return _reserved;
+	}
+
+	std::size_t arena::used() const noexcept {
+		return _used;
+	}
+
+
+	std::string_view interned::view() const noexcept {
+		return std::string_view(_data, _size);
+	}
+
+	interned::operator bool() const noexcept {
+		return _data != nullptr;
+	}
+
+	bool interned::operator==(const interned& other) const noexcept {
+		return _data == other._data;
+	}
+
+
+	intern_pool::intern_pool(std::size_t max_value_length)
+		: _slots(16), _hashes(16), _max_value_length(max_value_length) {
+	}
+
+	std::size_t intern_pool::slot(std::string_view str, std::size_t str_hash) const noexcept {
+		// linear probing, as in flat_map
+		auto mask = _slots.size() - 1;
+		for (auto i = str_hash & mask; ; i = (i + 1) & mask) {
+			if (!_slots[i] or (_hashes[i] == str_hash and _slots[i].view() == str)) {
+				return i;
+			}
+		}
+	}
+
+	void intern_pool::rehash() {
+		auto slots = std::vector<interned>(_slots.size() * 2);
+		auto hashes = std::vector<std::size_t>(slots.size());
+		auto mask = slots.size() - 1;
+		for (auto i = std::size_t(0); i < _slots.size(); ++i) {
+			if (!_slots[i]) {
+				continue;
+			}
+			auto j = _hashes[i] & mask;
+			while (slots[j]) {
+				j = (j + 1) & mask;
+			}
+			slots[j] = _slots[i];
+			hashes[j] = _hashes[i];
+		}
+		_slots = std::move(slots);
+		_hashes = std::move(hashes);
+	}
+
+	interned intern_pool::intern(std::string_view str) {
+		auto str_hash = std::hash<std::string_view>()(str);
+		{
+			auto lock = std::shared_lock(_mutex);
+			auto found = _slots[slot(str, str_hash)];
+			if (found) {
+				return found;
+			}
+		}
+
+		auto lock = std::unique_lock(_mutex);
+		// another thread may have interned it between the locks
+		auto i = slot(str, str_hash);
+		if (_slots[i]) {
+			return _slots[i];
+		}
+
+		// the arena gives no memory to empty strings, they share a static one
+		static const char EMPTY[] = "";
+		auto handle = interned();
+		handle._data = str.empty() ? EMPTY : _arena.store(str).data();
+		handle._size = (std::uint32_t)str.length();
+		_slots[i] = handle;
+		_hashes[i] = str_hash;
+		if (++_size * 2 > _slots.size()) {
+			rehash();
+		}
+		return handle;
+	}
+
+	interned intern_pool::find(std::string_view str) const {
+		auto lock = std::shared_lock(_mutex);
+		return _slots[slot(str, std::hash<std::string_view>()(str))];
+	}
+
+	std::size_t intern_pool::max_value_length() const noexcept {
+		return _max_value_length;
+	}
+
+	std::size_t intern_pool::size() const {
+		auto lock = std::shared_lock(_mutex);
+		return _size;
+	}
+
+	std::size_t intern_pool::used_bytes() const {
+		auto lock = std::shared_lock(_mutex);
+		return _arena.used();
+	}
+
+
+	arena_value::arena_value() noexcept
+		: _integer(0) {
+	}
+
+	value_type arena_value::type() const noexcept {
+		return _type;
+	}
+
+	bool arena_value::is_null() const noexcept {
+		return _type == value_type::V_NULL;
+	}
+
+	bool arena_value::as_bool() const {
+		check_type(value_type::V_BOOL);
+		return _boolean;
+	}
+
+	char arena_value::as_char() const {
+		check_type(value_type::V_CHAR);
+		return _character;
+	}
+
+	std::int64_t arena_value::as_int() const {
+		check_type(value_type::V_INT);
+		return _integer;
+	}
+
+	float arena_value::as_float() const {
+		check_type(value_type::V_FLOAT);
+		return _single;
+	}
+
+	double arena_value::as_double() const {
+		// floats widen to double, so either float type can be read as double
+		if (_type == value_type::V_FLOAT) {
+			return _single;
+		}
+		check_type(value_type::V_DOUBLE);
+		return _real;
+	}
+
+	std::string_view arena_value::as_string() const {
+		check_type(value_type::V_STRING);
+		return std::string_view(_string, _size);
+	}
+
+	std::span<const arena_value> arena_value::as_array() const {
+		check_type(value_type::V_ARRAY);
+		return std::span<const arena_value>(_array, _size);
+	}
+
+	value arena_value::to_value() const {
+		switch (_type) {
+		case value_type::V_BOOL:
+			return value(_boolean);
+		case value_type::V_CHAR:
+			return value(_character);
+		case value_type::V_INT:
+			return value((long long)_integer);
+		case value_type::V_FLOAT:
+			return value(_single);
+		case value_type::V_DOUBLE:
+			return value(_real);
+		case value_type::V_STRING:
+			return value(as_string());
+		case value_type::V_ARRAY: {
+			auto arr = value::array_type();
+			arr.reserve(_size);
+			for (auto& item : as_array()) {
+				arr.push_back(item.to_value());
+			}
+			return value(std::move(arr));
+		}
+		default:
+			return value();
+		}
+	}
+
+	void arena_value::check_type(value_type expected) const {
+		if (_type != expected) {
+			throw std::invalid_argument(build_type_error_message(_type, expected));
+		}
+	}
+
+
+	std::span<const arena_document::entry> arena_document::entries() const noexcept {
+		return _entries;
+	}
+
+	std::size_t arena_document::size() const noexcept {
+		return _entries.size();
+	}
+
+	const arena_value* arena_document::find(std::string_view key) const {
+		auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const entry& e, std::string_view k) {
+			return e.key < k;
+		});
+		if (it == _entries.end() or it->key != key) {
+			return nullptr;
+		}
+		return &it->value;
+	}
+
+	const arena_value* arena_document::find(interned key) const {
+		if (_entries.size() <= LINEAR_FIND_SIZE) {
+			for (auto& e : _entries) {
+				if (e.key.data() == key.view().data()) {
+					return &e.value;
+				}
+			}
+			return nullptr;
+		}
+
+		// the entry of an interned key holds the pool pointer, as the scan above expects
+		auto it = std::lower_bound(_entries.begin(), _entries.end(), key.view(), [](const entry& e, std::string_view k) {
+			return e.key < k;
+		});
+		if (it == _entries.end() or it->key.data() != key.view().data()) {
+			return nullptr;
+		}
+		return &it->value;
+	}
+
+	const arena_value& arena_document::at(std::string_view key) const {
+		auto found = find(key);
+		if (found == nullptr) {
+			std::stringstream msg;
+			msg << "Key '";
+			msg << key;
+			msg << "' not found.";
+			throw std::out_of_range(msg.str());
+		}
+		return *found;
+	}
+
+	const arena_stats& arena_document::stats() const noexcept {
+		return _stats;
+	}
+
+
+	void arena_builder::reset() {
+		_document = arena_document();
+		_key = std::string_view();
+		_entries.clear();
+		_items.clear();
+		_arr_starts.clear();
+	}
+
+	arena_document arena_builder::take() {
+		auto& doc_arena = _document._arena;
+
+		// sorted like a std::map, keeping the first value of a duplicated key
+		std::stable_sort(_entries.begin(), _entries.end(), [](const arena_document::entry& a, const arena_document::entry& b) {
+			return a.key < b.key;
+		});
+		auto last = std::unique(_entries.begin(), _entries.end(), [](const arena_document::entry& a, const arena_document::entry& b) {
+			return a.key == b.key;
+		});
+		auto count = (std::size_t)(last - _entries.begin());
+
+		auto entries = static_cast<arena_document::entry*>(doc_arena.allocate(sizeof(arena_document::entry) * std::max<std::size_t>(count, 1), alignof(arena_document::entry)));
+		std::uninitialized_copy(_entries.begin(), last, entries);
+		_document._entries = std::span<const arena_document::entry>(entries, count);
+
+		_document._stats.allocations = doc_arena.allocations();
+		_document._stats.reserved_bytes = doc_arena.reserved();
+		_document._stats.used_bytes = doc_arena.used();
+		_document._stats.process_peak_rss = process_peak_rss();
+
+		return std::move(_document);
+	}
+
+	void arena_builder::borrow(mapped_file&& file) {
+		_document._file = std::move(file);
+	}
+
+	void arena_builder::intern(intern_pool* pool) noexcept {
+		_pool = pool;
+	}
+
+	void arena_builder::on_key(std::string_view key) {
+		_key = _pool != nullptr ? _pool->intern(key).view() : store(key);
+	}
+
+	void arena_builder::on_null() {
+		set_value(arena_value());
+	}
+
+	void arena_builder::on_bool(bool v) {
+		auto item = arena_value();
+		item._boolean = v;
+		item._type = value_type::V_BOOL;
+		set_value(item);
+	}
+
+	void arena_builder::on_char(char v) {
+		auto item = arena_value();
+		item._character = v;
+		item._type = value_type::V_CHAR;
+		set_value(item);
+	}
+
+	void arena_builder::on_int(long long v) {
+		auto item = arena_value();
+		item._integer = v;
+		item._type = value_type::V_INT;
+		set_value(item);
+	}
+
+	void arena_builder::on_float(float v) {
+		auto item = arena_value();
+		item._single = v;
+		item._type = value_type::V_FLOAT;
+		set_value(item);
+	}
+
+	void arena_builder::on_double(double v) {
+		auto item = arena_value();
+		item._real = v;
+		item._type = value_type::V_DOUBLE;
+		set_value(item);
+	}
+
+	void arena_builder::on_long_double(long double v) {
+		on_double((double)v);
+	}
+
+	void arena_builder::on_string(std::string_view v) {
+		auto str = _pool != nullptr and v.length() <= _pool->max_value_length() ? _pool->intern(v).view() : store(v);
+		auto item = arena_value();
+		item._string = str.data();
+		item._size = (std::uint32_t)str.length();
+		item._type = value_type::V_STRING;
+		set_value(item);
+	}
+
+	void arena_builder::on_array_begin() {
+		_arr_starts.push_back(_items.size());
+	}
+
+	void arena_builder::on_array_end() {
+		// the items of the closed array are the last ones in the scratch stack, they are moved to the arena at once
+		auto start = _arr_starts.back();
+		_arr_starts.pop_back();
+		auto count = _items.size() - start;
+
+		auto item = arena_value();
+		auto items = static_cast<arena_value*>(_document._arena.allocate(sizeof(arena_value) * std::max<std::size_t>(count, 1), alignof(arena_value)));
+		std::uninitialized_copy(_items.begin() + start, _items.end(), items);
+		_items.resize(start);
+
+		item._array = items;
+		item._size = (std::uint32_t)count;
+		item._type = value_type::V_ARRAY;
+		set_value(item);
+	}
+
+	std::string_view arena_builder::store(std::string_view str) {
+		if (_document._file.contains(str)) {
+			return str;
+		}
+		return _document._arena.store(str);
+	}
+
+	void arena_builder::set_value(const arena_value& item) {
+		if (!_arr_starts.empty()) {
+			_items.push_back(item);
+		}
+		else {
+			_entries.push_back(arena_document::entry{ _key, item });
+		}
+	}
+
+
+	std::size_t process_peak_rss() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+			return counters.PeakWorkingSetSize;
+		}
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) == 0) {
+			// linux reports kilobytes
+			return (std::size_t)usage.ru_maxrss * 1024;
+		}
+		return 0;
+#endif
+	}
+
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_file.hpp"
+
+
+namespace bps_core {
+
+	// monotonic allocator, memory is only given back when the whole arena is released
+	class arena {
+	private:
+		struct chunk {
+			chunk* next;
+			std::size_t size;
+			std::size_t used;
+		};
+
+		static const std::size_t MIN_CHUNK_SIZE;
+		static const std::size_t MAX_CHUNK_SIZE;
+
+		chunk* _head = nullptr;
+
+		std::size_t _allocations = 0;
+		std::size_t _reserved = 0;
+		std::size_t _used = 0;
+
+	public:
+		arena() = default;
+		arena(const arena&) = delete;
+		arena(arena&&) noexcept;
+		arena& operator=(const arena&) = delete;
+		arena& operator=(arena&&) noexcept;
+		~arena();
+
+		void* allocate(std::size_t, std::size_t);
+		std::string_view store(std::string_view);
+		void release() noexcept;
+
+		// number of chunks requested to the system allocator
+		std::size_t allocations() const noexcept;
+		std::size_t reserved() const noexcept;
+		std::size_t used() const noexcept;
+	};
+
+	// string stored once in an intern_pool, the handles a pool gives for equal strings hold the same
+	// pointer so they are compared without reading the strings. A default handle holds no string
+	class interned {
+	private:
+		const char* _data = nullptr;
+		std::uint32_t _size = 0;
+
+		friend class intern_pool;
+
+	public:
+		interned() noexcept = default;
+
+		std::string_view view() const noexcept;
+
+		explicit operator bool() const noexcept;
+		bool operator==(const interned&) const noexcept;
+	};
+
+	// pool storing each distinct string once, shared by many parses so repeated keys are only stored the
+	// first time they are seen. Any number of threads can intern at once, strings already in the pool are
+	// found under a shared lock. The strings live as long as the pool
+	class intern_pool {
+	private:
+		mutable std::shared_mutex _mutex;
+		arena _arena;
+
+		// open addressing table of the interned strings and their hashes, kept at most half full
+		std::vector<interned> _slots;
+		std::vector<std::size_t> _hashes;
+		std::size_t _size = 0;
+
+		std::size_t _max_value_length;
+
+		// slot holding str, or the empty slot it would be interned in
+		std::size_t slot(std::string_view, std::size_t) const noexcept;
+		void rehash();
+
+	public:
+		// string values up to max_value_length chars are interned along with the keys, 0 interns keys only
+		explicit intern_pool(std::size_t max_value_length = 0);
+		intern_pool(const intern_pool&) = delete;
+		intern_pool& operator=(const intern_pool&) = delete;
+
+		interned intern(std::string_view);
+		// handle of an interned string, a default handle if it was never interned
+		interned find(std::string_view) const;
+
+		std::size_t max_value_length() const noexcept;
+		std::size_t size() const;
+		std::size_t used_bytes() const;
+	};
+
+	// value stored in an arena, strings and arrays point to arena memory
+	class arena_value {
+	private:
+		union {
+			bool _boolean;
+			char _character;
+			std::int64_t _integer;
+			float _single;
+			double _real;
+			const char* _string;
+			const arena_value* _array;
+		};
+		std::uint32_t _size = 0;
+		value_type _type = value_type::V_NULL;
+
+		friend class arena_builder;
+
+	public:
+		arena_value() noexcept;
+
+		value_type type() const noexcept;
+
+		bool is_null() const noexcept;
+		bool as_bool() const;
+		char as_char() const;
+		std::int64_t as_int() const;
+		float as_float() const;
+		double as_double() const;
+		std::string_view as_string() const;
+		std::span<const arena_value> as_array() const;
+
+		// copies the arena value into an owning value
+		value to_value() const;
+
+	private:
+		void check_type(value_type) const;
+	};
+
+	struct arena_stats {
+		// system allocator calls made for the document
+		std::size_t allocations = 0;
+		std::size_t reserved_bytes = 0;
+		std::size_t used_bytes = 0;
+		// peak resident set size of the whole process over its lifetime, read after the parse, which
+		// tells the memory high water mark, not the memory of the document
+		std::size_t process_peak_rss = 0;
+	};
+
+	// document whose keys, values and strings all live in one arena, dropping it releases them at once
+	class arena_document {
+	public:
+		struct entry {
+			std::string_view key;
+			arena_value value;
+		};
+
+	private:
+		arena _arena;
+		std::span<const entry> _entries;
+		arena_stats _stats;
+		// file the keys and strings borrowed by the document point into
+		mapped_file _file;
+
+		friend class arena_builder;
+
+	public:
+		// most keys a document scans by pointer when found by interned key
+		static constexpr std::size_t LINEAR_FIND_SIZE = 32;
+
+		arena_document() = default;
+
+		// entries sorted by key, as a std::map would iterate them
+		std::span<const entry> entries() const noexcept;
+		std::size_t size() const noexcept;
+
+		const arena_value* find(std::string_view) const;
+		// finds a key in a document built with the pool of the handle. Documents of up to LINEAR_FIND_SIZE
+		// keys are scanned comparing pointers only, larger ones are searched by key as find(string_view)
+		const arena_value* find(interned) const;
+		const arena_value& at(std::string_view) const;
+
+		const arena_stats& stats() const noexcept;
+	};
+
+	// builds an arena_document from the parser events, its scratch buffers are kept between parses
+	class arena_builder {
+	private:
+		arena_document _document;
+		intern_pool* _pool = nullptr;
+
+		std::string_view _key;
+		std::vector<arena_document::entry> _entries;
+		std::vector<arena_value> _items;
+		std::vector<std::size_t> _arr_starts;
+
+		void set_value(const arena_value&);
+		std::string_view store(std::string_view);
+
+	public:
+		using document_type = arena_document;
+
+		void reset();
+		arena_document take();
+
+		// keys and strings lying in the file are referenced instead of copied, the document takes the file
+		void borrow(mapped_file&&);
+		// keys, and strings up to the pool max value length, are interned in the pool instead of stored in
+		// the document, which then needs the pool to outlive it. nullptr stops interning
+		void intern(intern_pool*) noexcept;
+
+		void on_key(std::string_view);
+		void on_null();
+		void on_bool(bool);
+		void on_char(char);
+		void on_int(long long);
+		void on_float(float);
+		void on_double(double);
+		void on_long_double(long double);
+		void on_string(std::string_view);
+		void on_array_begin();
+		void on_array_end();
+	};
+
+	using arena_parser = basic_parser<arena_builder>;
+
+	// peak resident set size of the current process since it started in bytes, 0 if unknown
+	std::size_t process_peak_rss();
+
+}
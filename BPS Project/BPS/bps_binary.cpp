@@ -0,0 +1,532 @@
+#include "pch.h"
+#include "bps_binary.hpp"
+
+namespace bps_core {
+
+	static_assert(std::endian::native == std::endian::little, "the BPS binary layout is read in place as little endian");
+
+	// deepest array nesting verify walks into
+	const int MAX_VERIFY_DEPTH = 1024;
+
+	[[noreturn]] static void invalid_binary(std::string problem) {
+		std::stringstream msg;
+		msg << "Invalid BPS binary data, ";
+		msg << problem;
+		msg << ".";
+		throw std::invalid_argument(msg.str());
+	}
+
+	binary_value::binary_value() noexcept {
+	}
+
+	value_type binary_value::type() const noexcept {
+		return _type;
+	}
+
+	value_type binary_value::item_type() const noexcept {
+		return _item_type;
+	}
+
+	std::size_t binary_value::size() const noexcept {
+		return _size;
+	}
+
+	bool binary_value::is_null() const noexcept {
+		return _type == value_type::V_NULL;
+	}
+
+	bool binary_value::as_bool() const {
+		check_type(value_type::V_BOOL);
+		return _boolean;
+	}
+
+	char binary_value::as_char() const {
+		check_type(value_type::V_CHAR);
+		return _character;
+	}
+
+	std::int64_t binary_value::as_int() const {
+		check_type(value_type::V_INT);
+		return _integer;
+	}
+
+	float binary_value::as_float() const {
+		check_type(value_type::V_FLOAT);
+		return _single;
+	}
+
+	double binary_value::as_double() const {
+		// floats widen to double, so either float type can be read as double
+		if (_type == value_type::V_FLOAT) {
+			return _single;
+		}
+		check_type(value_type::V_DOUBLE);
+		return _real;
+	}
+
+	std::string_view binary_value::as_string() const {
+		check_type(value_type::V_STRING);
+		return std::string_view(data(), _size);
+	}
+
+	std::span<const binary_value> binary_value::as_array() const {
+		check_item_type(value_type::V_NULL);
+		return std::span<const binary_value>(reinterpret_cast<const binary_value*>(data()), _size);
+	}
+
+	std::span<const std::int64_t> binary_value::as_int_array() const {
+		check_item_type(value_type::V_INT);
+		return std::span<const std::int64_t>(reinterpret_cast<const std::int64_t*>(data()), _size);
+	}
+
+	std::span<const float> binary_value::as_float_array() const {
+		check_item_type(value_type::V_FLOAT);
+		return std::span<const float>(reinterpret_cast<const float*>(data()), _size);
+	}
+
+	std::span<const double> binary_value::as_double_array() const {
+		check_item_type(value_type::V_DOUBLE);
+		return std::span<const double>(reinterpret_cast<const double*>(data()), _size);
+	}
+
+	value binary_value::to_value() const {
+		switch (_type) {
+		case value_type::V_BOOL:
+			return value(_boolean);
+		case value_type::V_CHAR:
+			return value(_character);
+		case value_type::V_INT:
+			return value((long long)_integer);
+		case value_type::V_FLOAT:
+			return value(_single);
+		case value_type::V_DOUBLE:
+			return value(_real);
+		case value_type::V_STRING:
+			return value(as_string());
+		case value_type::V_ARRAY: {
+			auto arr = value::array_type();
+			arr.reserve(_size);
+			switch (_item_type) {
+			case value_type::V_INT:
+				for (auto item : as_int_array()) {
+					arr.emplace_back((long long)item);
+				}
+				break;
+			case value_type::V_FLOAT:
+				for (auto item : as_float_array()) {
+					arr.emplace_back(item);
+				}
+				break;
+			case value_type::V_DOUBLE:
+				for (auto item : as_double_array()) {
+					arr.emplace_back(item);
+				}
+				break;
+			default:
+				for (auto& item : as_array()) {
+					arr.push_back(item.to_value());
+				}
+			}
+			return value(std::move(arr));
+		}
+		default:
+			return value();
+		}
+	}
+
+	const char* binary_value::data() const noexcept {
+		return reinterpret_cast<const char*>(this) + _offset;
+	}
+
+	void binary_value::check_type(value_type expected) const {
+		if (_type != expected) {
+			throw std::invalid_argument(build_type_error_message(_type, expected));
+		}
+	}
+
+	void binary_value::check_item_type(value_type expected) const {
+		check_type(value_type::V_ARRAY);
+		if (_item_type != expected) {
+			throw std::invalid_argument(build_type_error_message(_item_type, expected));
+		}
+	}
+
+	bool binary_value::verify(const char* begin, std::size_t size, int depth) const noexcept {
+		if (_type > value_type::V_ARRAY) {
+			return false;
+		}
+		if (_type != value_type::V_STRING and _type != value_type::V_ARRAY) {
+			return true;
+		}
+
+		auto item_size = std::size_t(1);
+		if (_type == value_type::V_ARRAY) {
+			switch (_item_type) {
+			case value_type::V_NULL:
+				item_size = sizeof(binary_value);
+				break;
+			case value_type::V_INT:
+			case value_type::V_DOUBLE:
+				item_size = 8;
+				break;
+			case value_type::V_FLOAT:
+				item_size = 4;
+				break;
+			default:
+				return false;
+			}
+		}
+
+		auto first = reinterpret_cast<const char*>(this) - begin + _offset;
+		if (first < 0 or (std::size_t)first > size or (size - first) / item_size < _size) {
+			return false;
+		}
+		if (first % std::min(item_size, alignof(std::uint64_t)) != 0) {
+			return false;
+		}
+		if (_type == value_type::V_ARRAY and _item_type == value_type::V_NULL) {
+			if (depth >= MAX_VERIFY_DEPTH) {
+				return false;
+			}
+			for (auto& item : as_array()) {
+				if (!item.verify(begin, size, depth + 1)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+
+	std::string_view binary_document::entry::key() const noexcept {
+		return std::string_view(reinterpret_cast<const char*>(this) + _key, _key_size);
+	}
+
+	void binary_document::load(std::string_view data) {
+		_file.close();
+		_data = data;
+		index();
+	}
+
+	void binary_document::load(mapped_file&& file) {
+		_file = std::move(file);
+		_data = _file.view();
+		index();
+	}
+
+	void binary_document::index() {
+		_entries = std::span<const entry>();
+
+		if (reinterpret_cast<std::uintptr_t>(_data.data()) % alignof(std::uint64_t) != 0) {
+			invalid_binary("it is not 8 byte aligned");
+		}
+		if (_data.length() < sizeof(binary_header)) {
+			invalid_binary("its header is missing");
+		}
+
+		auto& header = *reinterpret_cast<const binary_header*>(_data.data());
+		if (std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+			invalid_binary("its magic number is wrong");
+		}
+		if (header.version != BINARY_VERSION) {
+			invalid_binary("its version is not supported");
+		}
+		if (header.size < sizeof(binary_header) or header.size > _data.length()
+			or (header.size - sizeof(binary_header)) / sizeof(entry) < header.count) {
+			invalid_binary("it is truncated");
+		}
+		_data = _data.substr(0, (std::size_t)header.size);
+
+		// only the keys are checked, so keys can be looked up without reading past the data
+		auto entries = reinterpret_cast<const entry*>(_data.data() + sizeof(binary_header));
+		for (auto i = std::size_t(0); i < header.count; ++i) {
+			auto first = (std::int64_t)(sizeof(binary_header) + i * sizeof(entry)) + entries[i]._key;
+			if (first < 0 or (std::size_t)first > _data.length() or _data.length() - first < entries[i]._key_size) {
+				invalid_binary("a key lies out of it");
+			}
+			if (i > 0 and !(entries[i - 1].key() < entries[i].key())) {
+				invalid_binary("its keys are not sorted");
+			}
+		}
+		_entries = std::span<const entry>(entries, header.count);
+	}
+
+	void binary_document::verify() const {
+		for (auto& e : _entries) {
+			if (!e.value.verify(_data.data(), _data.length(), 0)) {
+				std::stringstream msg;
+				msg << "the value of key '";
+				msg << e.key();
+				msg << "' lies out of it";
+				invalid_binary(msg.str());
+			}
+		}
+	}
+
+	std::span<const binary_document::entry> binary_document::entries() const noexcept {
+		return _entries;
+	}
+
+	std::size_t binary_document::size() const noexcept {
+		return _entries.size();
+	}
+
+	const binary_value* binary_document::find(std::string_view key) const {
+		auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const entry& e, std::string_view k) {
+			return e.key() < k;
+		});
+		if (it == _entries.end() or it->key() != key) {
+			return nullptr;
+		}
+		return &it->value;
+	}
+
+	const binary_value& binary_document::at(std::string_view key) const {
+		auto found = find(key);
+		if (found == nullptr) {
+			std::stringstream msg;
+			msg << "Key '";
+			msg << key;
+			msg << "' not found.";
+			throw std::out_of_range(msg.str());
+		}
+		return *found;
+	}
+
+	std::map<std::string, value> binary_document::to_map() const {
+		auto data = std::map<std::string, value>();
+		for (auto& e : _entries) {
+			data.emplace_hint(data.end(), e.key(), e.value.to_value());
+		}
+		return data;
+	}
+
+	std::map<std::string, std::any> binary_document::to_any_map() const {
+		auto data = std::map<std::string, std::any>();
+		for (auto& e : _entries) {
+			data.emplace_hint(data.end(), e.key(), e.value.to_value().to_any());
+		}
+		return data;
+	}
+
+
+	// zeros up to the next 8 byte boundary, counted from the output start
+	static void pad(std::string& output) {
+		output.append((alignof(std::uint64_t) - output.length() % alignof(std::uint64_t)) % alignof(std::uint64_t), '\0');
+	}
+
+	static std::uint32_t checked_size(std::size_t size) {
+		if (size > std::numeric_limits<std::uint32_t>::max()) {
+			throw std::length_error("BPS binary strings and arrays are limited to 2^32 - 1 items.");
+		}
+		return (std::uint32_t)size;
+	}
+
+	static const value& to_value(const value& v) {
+		return v;
+	}
+
+	static value to_value(const std::any& v) {
+		return value::from_any(v);
+	}
+
+	template<class Document>
+	std::string binary::parse_document(const Document& data) {
+		_buffer.clear();
+		write(data, _buffer);
+		return _buffer;
+	}
+
+	template<class Document>
+	void binary::write_document(const Document& data, std::string& output) {
+		pad(output);
+		auto start = output.length();
+		begin(data.size(), output);
+
+		// the directory is sorted by key whatever order the document iterates in
+		auto entries = std::vector<const typename Document::value_type*>();
+		entries.reserve(data.size());
+		for (auto& d : data) {
+			entries.push_back(&d);
+		}
+		auto by_key = [](auto a, auto b) {
+			return a->first < b->first;
+		};
+		if (!std::is_sorted(entries.begin(), entries.end(), by_key)) {
+			std::sort(entries.begin(), entries.end(), by_key);
+		}
+
+		auto at = start + sizeof(binary_header);
+		for (auto d : entries) {
+			write_entry(d->first, to_value(d->second), at, output);
+			at += sizeof(binary_document::entry);
+		}
+		end(start, output);
+	}
+
+	std::string binary::parse(const std::map<std::string, std::any>& data) {
+		return parse_document(data);
+	}
+
+	std::string binary::parse(const std::map<std::string, value>& data) {
+		return parse_document(data);
+	}
+
+	std::string binary::parse(const flat_map<std::any>& data) {
+		return parse_document(data);
+	}
+
+	std::string binary::parse(const flat_map<value>& data) {
+		return parse_document(data);
+	}
+
+	void binary::write(const std::map<std::string, std::any>& data, std::string& output) {
+		write_document(data, output);
+	}
+
+	void binary::write(const std::map<std::string, value>& data, std::string& output) {
+		write_document(data, output);
+	}
+
+	void binary::write(const flat_map<std::any>& data, std::string& output) {
+		write_document(data, output);
+	}
+
+	void binary::write(const flat_map<value>& data, std::string& output) {
+		write_document(data, output);
+	}
+
+	void binary::begin(std::size_t count, std::string& output) {
+		auto header = binary_header();
+		std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+		header.version = BINARY_VERSION;
+		header.count = checked_size(count);
+		output.append(reinterpret_cast<const char*>(&header), sizeof(header));
+		// the directory is filled in as the values are written after it
+		output.append(count * sizeof(binary_document::entry), '\0');
+	}
+
+	void binary::end(std::size_t start, std::string& output) {
+		pad(output);
+		auto size = (std::uint64_t)(output.length() - start);
+		std::memcpy(output.data() + start + offsetof(binary_header, size), &size, sizeof(size));
+	}
+
+	void binary::write_entry(std::string_view key, const value& v, std::size_t at, std::string& output) {
+		auto e = binary_document::entry();
+		e._key = (std::int64_t)(output.length() - at);
+		e._key_size = checked_size(key.length());
+		output.append(key);
+		std::memcpy(output.data() + at, &e, sizeof(e));
+
+		// the value slot ends the entry
+		write_value(v, at + sizeof(binary_document::entry) - sizeof(binary_value), output);
+	}
+
+	void binary::write_value(const value& v, std::size_t at, std::string& output) {
+		auto slot = binary_value();
+		slot._type = v.type();
+
+		switch (v.type()) {
+		case value_type::V_BOOL:
+			slot._boolean = v.as_bool();
+			break;
+		case value_type::V_CHAR:
+			slot._character = v.as_char();
+			break;
+		case value_type::V_INT:
+			slot._integer = v.as_int();
+			break;
+		case value_type::V_FLOAT:
+			slot._single = v.as_float();
+			break;
+		case value_type::V_DOUBLE:
+			slot._real = v.as_double();
+			break;
+		case value_type::V_STRING: {
+			auto str = v.as_string();
+			slot._size = checked_size(str.length());
+			slot._offset = (std::int64_t)(output.length() - at);
+			output.append(str);
+			break;
+		}
+		case value_type::V_ARRAY: {
+			auto& arr = v.as_array();
+			slot._size = checked_size(arr.size());
+
+			// arrays whose items are all integers, all floats or all doubles are stored typed
+			auto item_type = arr.empty() ? value_type::V_NULL : arr.front().type();
+			if (item_type != value_type::V_INT and item_type != value_type::V_FLOAT and item_type != value_type::V_DOUBLE) {
+				item_type = value_type::V_NULL;
+			}
+			for (auto& item : arr) {
+				if (item.type() != item_type) {
+					item_type = value_type::V_NULL;
+					break;
+				}
+			}
+			slot._item_type = item_type;
+
+			pad(output);
+			auto first = output.length();
+			slot._offset = (std::int64_t)(first - at);
+			switch (item_type) {
+			case value_type::V_INT:
+				for (auto& item : arr) {
+					auto n = item.as_int();
+					output.append(reinterpret_cast<const char*>(&n), sizeof(n));
+				}
+				break;
+			case value_type::V_FLOAT:
+				for (auto& item : arr) {
+					auto n = item.as_float();
+					output.append(reinterpret_cast<const char*>(&n), sizeof(n));
+				}
+				break;
+			case value_type::V_DOUBLE:
+				for (auto& item : arr) {
+					auto n = item.as_double();
+					output.append(reinterpret_cast<const char*>(&n), sizeof(n));
+				}
+				break;
+			default:
+				// the slots are laid out first, the items they point to after them
+				output.append(arr.size() * sizeof(binary_value), '\0');
+				for (auto i = std::size_t(0); i < arr.size(); ++i) {
+					write_value(arr[i], first + i * sizeof(binary_value), output);
+				}
+			}
+			break;
+		}
+		case value_type::V_TYPED_ARRAY: {
+			auto& arr = v.as_typed_array();
+			if (arr.shape().size() != 1 or (arr.type() != value_type::V_INT and arr.type() != value_type::V_DOUBLE)) {
+				// other typed arrays are stored as nested slot arrays
+				write_value(value(arr.to_array()), at, output);
+				return;
+			}
+
+			// one dimension of integers or doubles is already laid out as a typed binary array
+			slot._type = value_type::V_ARRAY;
+			slot._item_type = arr.type();
+			slot._size = checked_size(arr.size());
+			pad(output);
+			slot._offset = (std::int64_t)(output.length() - at);
+			if (arr.type() == value_type::V_INT) {
+				auto items = arr.as_span<std::int64_t>();
+				output.append(reinterpret_cast<const char*>(items.data()), items.size_bytes());
+			}
+			else {
+				auto items = arr.as_span<double>();
+				output.append(reinterpret_cast<const char*>(items.data()), items.size_bytes());
+			}
+			break;
+		}
+		default:
+			break;
+		}
+
+		std::memcpy(output.data() + at, &slot, sizeof(slot));
+	}
+
+}
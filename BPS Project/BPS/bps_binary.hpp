@@ -0,0 +1,166 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_value.hpp"
+#include "bps_file.hpp"
+#include "bps_flat.hpp"
+
+
+namespace bps_core {
+
+	// BPS binary layout, little endian, every structure 8 byte aligned:
+	// a header, the key directory sorted by key, then keys, strings and arrays.
+	// Offsets are relative to the structure holding them, so a document is read in place wherever it lies
+	struct binary_header {
+		char magic[4];
+		std::uint16_t version;
+		std::uint16_t reserved;
+		// number of keys
+		std::uint32_t count;
+		std::uint32_t reserved2;
+		// bytes from the header start to the data end
+		std::uint64_t size;
+	};
+
+	const char BINARY_MAGIC[4] = { 'B', 'P', 'S', 'B' };
+	const std::uint16_t BINARY_VERSION = 1;
+
+	// value slot read in place, strings and arrays point past it.
+	// Arrays of integers, floats or doubles only are stored as a contiguous typed array,
+	// other arrays as a contiguous array of slots
+	class binary_value {
+	private:
+		value_type _type = value_type::V_NULL;
+		// type of the typed array items, null for arrays of slots
+		value_type _item_type = value_type::V_NULL;
+		std::uint16_t _reserved = 0;
+		// string length or array size
+		std::uint32_t _size = 0;
+		union {
+			bool _boolean;
+			char _character;
+			std::int64_t _integer;
+			float _single;
+			double _real;
+			std::int64_t _offset = 0;
+		};
+
+		friend class binary;
+		friend class binary_document;
+
+	public:
+		binary_value() noexcept;
+
+		value_type type() const noexcept;
+		// type of the typed array items, null for other arrays and values
+		value_type item_type() const noexcept;
+		// string length or array size
+		std::size_t size() const noexcept;
+
+		bool is_null() const noexcept;
+		bool as_bool() const;
+		char as_char() const;
+		std::int64_t as_int() const;
+		float as_float() const;
+		double as_double() const;
+		std::string_view as_string() const;
+		// arrays of slots
+		std::span<const binary_value> as_array() const;
+		// typed arrays
+		std::span<const std::int64_t> as_int_array() const;
+		std::span<const float> as_float_array() const;
+		std::span<const double> as_double_array() const;
+
+		// copies the binary value into an owning value
+		value to_value() const;
+
+	private:
+		const char* data() const noexcept;
+		void check_type(value_type) const;
+		void check_item_type(value_type) const;
+		// whether the value and what it points to lie in the first bytes from begin
+		bool verify(const char*, std::size_t, int) const noexcept;
+	};
+
+	static_assert(sizeof(binary_value) == 16, "binary_value is a 16 byte slot of the binary layout");
+
+	// document read in place from BPS binary data, loading only checks the header and the key directory
+	class binary_document {
+	public:
+		class entry {
+		private:
+			std::int64_t _key = 0;
+			std::uint32_t _key_size = 0;
+			std::uint32_t _reserved = 0;
+
+			friend class binary;
+			friend class binary_document;
+
+		public:
+			binary_value value;
+
+			std::string_view key() const noexcept;
+		};
+
+	private:
+		std::string_view _data;
+		std::span<const entry> _entries;
+		mapped_file _file;
+
+		void index();
+
+	public:
+		binary_document() = default;
+
+		// reads data in place, data must be 8 byte aligned and outlive the document
+		void load(std::string_view);
+		// reads the file in place, the document keeps it mapped
+		void load(mapped_file&&);
+
+		// checks every value points inside the data, for data that may be corrupt
+		void verify() const;
+
+		// entries sorted by key, as a std::map would iterate them
+		std::span<const entry> entries() const noexcept;
+		std::size_t size() const noexcept;
+
+		const binary_value* find(std::string_view) const;
+		const binary_value& at(std::string_view) const;
+
+		std::map<std::string, value> to_map() const;
+		// binary data holds floats and doubles only, so long double values written to it are read back as double
+		std::map<std::string, std::any> to_any_map() const;
+	};
+
+	static_assert(sizeof(binary_document::entry) == 32, "binary_document::entry is a 32 byte entry of the binary layout");
+
+	// writes BPS binary data, the output buffer is kept between calls
+	class binary {
+	private:
+		std::string _buffer;
+
+	public:
+		std::string parse(const std::map<std::string, std::any>&);
+		std::string parse(const std::map<std::string, value>&);
+		std::string parse(const flat_map<std::any>&);
+		std::string parse(const flat_map<value>&);
+
+		// appends the binary data to output, padded to start 8 bytes aligned from the output start
+		void write(const std::map<std::string, std::any>&, std::string&);
+		void write(const std::map<std::string, value>&, std::string&);
+		void write(const flat_map<std::any>&, std::string&);
+		void write(const flat_map<value>&, std::string&);
+
+	private:
+		template<class Document>
+		std::string parse_document(const Document&);
+		template<class Document>
+		void write_document(const Document&, std::string&);
+
+		void begin(std::size_t, std::string&);
+		void end(std::size_t, std::string&);
+		void write_value(const value&, std::size_t, std::string&);
+		void write_entry(std::string_view, const value&, std::size_t, std::string&);
+	};
+
+}
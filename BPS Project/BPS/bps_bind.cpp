@@ -0,0 +1,22 @@
+#include "pch.h"
+#include "bps_bind.hpp"
+
+namespace bps_core {
+
+	std::string build_bind_error_message(std::string_view key, value_type type, value_type expected) {
+		std::stringstream msg;
+		msg << "Key '";
+		msg << key;
+		msg << "' can not hold its value. ";
+		// floats are narrowed to float members, they only fail when out of range
+		auto floats = (type == value_type::V_FLOAT or type == value_type::V_DOUBLE) and (expected == value_type::V_FLOAT or expected == value_type::V_DOUBLE);
+		if (type == expected or floats) {
+			msg << "The value is out of range.";
+		}
+		else {
+			msg << build_type_error_message(type, expected);
+		}
+		return msg.str();
+	}
+
+}
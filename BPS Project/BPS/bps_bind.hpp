@@ -0,0 +1,465 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+
+
+// declares the fields of a struct and their BPS keys, at global scope:
+// BPS_SCHEMA(point, BPS_FIELD(x, "x"), BPS_FIELD(label, "label"));
+#define BPS_FIELD(member, key) ::bps_core::field(key, &bps_self::member)
+#define BPS_SCHEMA(type, ...) \
+	template<> \
+	struct bps_core::schema<type> { \
+		using bps_self = type; \
+		static constexpr auto fields = std::make_tuple(__VA_ARGS__); \
+	}
+
+
+namespace bps_core {
+
+	// a public member of T bound to a BPS key
+	template<class T, class M>
+	struct field {
+		std::string_view key;
+		M T::* member;
+
+		constexpr field(std::string_view key, M T::* member)
+			: key(key), member(member) {
+		}
+	};
+
+	// fields of T, specialized by BPS_SCHEMA with a tuple of field
+	template<class T>
+	struct schema;
+
+	template<class T>
+	concept bound = requires { schema<T>::fields; };
+
+	template<class M>
+	struct is_vector : std::false_type {
+	};
+
+	template<class U>
+	struct is_vector<std::vector<U>> : std::true_type {
+	};
+
+	// type of the BPS value a member of type M holds
+	template<class M>
+	constexpr value_type bound_type() {
+		if constexpr (std::is_same_v<M, bool>) {
+			return value_type::V_BOOL;
+		}
+		else if constexpr (std::is_same_v<M, char>) {
+			return value_type::V_CHAR;
+		}
+		else if constexpr (std::is_integral_v<M>) {
+			return value_type::V_INT;
+		}
+		else if constexpr (std::is_same_v<M, float>) {
+			return value_type::V_FLOAT;
+		}
+		else if constexpr (std::is_floating_point_v<M>) {
+			return value_type::V_DOUBLE;
+		}
+		else if constexpr (std::is_same_v<M, std::string>) {
+			return value_type::V_STRING;
+		}
+		else if constexpr (is_vector<M>::value) {
+			return value_type::V_ARRAY;
+		}
+		else {
+			static_assert(is_vector<M>::value, "bound members are bool, char, integers, floats, std::string or std::vector of them");
+		}
+	}
+
+	struct bind_handlers;
+
+	// where the next parsed value is written: a member, or the vector an array appends to
+	struct bind_target {
+		void* object;
+		const bind_handlers* handlers;
+	};
+
+	// writes the parser events into a target, each handler returns false when the value does not fit it
+	struct bind_handlers {
+		value_type type;
+		bool (*on_null)(void*);
+		bool (*on_bool)(void*, bool);
+		bool (*on_char)(void*, char);
+		bool (*on_int)(void*, long long);
+		bool (*on_double)(void*, long double);
+		bool (*on_string)(void*, std::string_view);
+		// the target the array items are written to, with null handlers if the target holds no array
+		bind_target (*on_array_begin)(void*);
+	};
+
+	// handlers that set a member of type M
+	template<class M>
+	struct bind_value {
+		static bool on_null(void* target) {
+			*static_cast<M*>(target) = M();
+			return true;
+		}
+
+		static bool on_bool(void* target, bool v) {
+			if constexpr (std::is_same_v<M, bool>) {
+				*static_cast<M*>(target) = v;
+				return true;
+			}
+			return false;
+		}
+
+		static bool on_char(void* target, char v) {
+			if constexpr (std::is_same_v<M, char>) {
+				*static_cast<M*>(target) = v;
+				return true;
+			}
+			return false;
+		}
+
+		static bool on_int(void* target, long long v) {
+			if constexpr (bound_type<M>() == value_type::V_INT) {
+				if (!std::in_range<M>(v)) {
+					return false;
+				}
+				*static_cast<M*>(target) = (M)v;
+				return true;
+			}
+			// integer constants widen to floats
+			else if constexpr (std::is_floating_point_v<M>) {
+				*static_cast<M*>(target) = (M)v;
+				return true;
+			}
+			return false;
+		}
+
+		static bool on_double(void* target, long double v) {
+			if constexpr (std::is_floating_point_v<M>) {
+				// as integers, floats that do not fit the member are not narrowed to infinity
+				if (std::isfinite(v) and (v > (long double)std::numeric_limits<M>::max() or v < (long double)std::numeric_limits<M>::lowest())) {
+					return false;
+				}
+				*static_cast<M*>(target) = (M)v;
+				return true;
+			}
+			return false;
+		}
+
+		static bool on_string(void* target, std::string_view v) {
+			if constexpr (std::is_same_v<M, std::string>) {
+				static_cast<M*>(target)->assign(v);
+				return true;
+			}
+			return false;
+		}
+
+		static bind_target on_array_begin(void* target);
+
+		static constexpr bind_handlers table = {
+			bound_type<M>(), on_null, on_bool, on_char, on_int, on_double, on_string, on_array_begin
+		};
+	};
+
+	// handlers that append to a vector of U, the items of an array
+	template<class U>
+	struct bind_items {
+		template<class V, class Handler>
+		static bool append(void* target, V v, Handler handler) {
+			auto item = U();
+			if (!handler(&item, v)) {
+				return false;
+			}
+			static_cast<std::vector<U>*>(target)->push_back(std::move(item));
+			return true;
+		}
+
+		static bool on_null(void* target) {
+			static_cast<std::vector<U>*>(target)->emplace_back();
+			return true;
+		}
+
+		static bool on_bool(void* target, bool v) {
+			return append(target, v, bind_value<U>::on_bool);
+		}
+
+		static bool on_char(void* target, char v) {
+			return append(target, v, bind_value<U>::on_char);
+		}
+
+		static bool on_int(void* target, long long v) {
+			return append(target, v, bind_value<U>::on_int);
+		}
+
+		static bool on_double(void* target, long double v) {
+			return append(target, v, bind_value<U>::on_double);
+		}
+
+		static bool on_string(void* target, std::string_view v) {
+			return append(target, v, bind_value<U>::on_string);
+		}
+
+		static bind_target on_array_begin(void* target) {
+			// a nested array is a new item, its own items are appended to it
+			if constexpr (is_vector<U>::value) {
+				auto& items = static_cast<std::vector<U>*>(target)->emplace_back();
+				return bind_target{ &items, &bind_items<typename U::value_type>::table };
+			}
+			return bind_target{ nullptr, nullptr };
+		}
+
+		static constexpr bind_handlers table = {
+			bound_type<U>(), on_null, on_bool, on_char, on_int, on_double, on_string, on_array_begin
+		};
+	};
+
+	template<class M>
+	bind_target bind_value<M>::on_array_begin(void* target) {
+		if constexpr (is_vector<M>::value) {
+			static_cast<M*>(target)->clear();
+			return bind_target{ target, &bind_items<typename M::value_type>::table };
+		}
+		return bind_target{ nullptr, nullptr };
+	}
+
+	// handlers of keys out of the schema and of repeated keys, whose values are skipped
+	struct bind_ignore {
+		static bool on_null(void*) {
+			return true;
+		}
+
+		static bool on_bool(void*, bool) {
+			return true;
+		}
+
+		static bool on_char(void*, char) {
+			return true;
+		}
+
+		static bool on_int(void*, long long) {
+			return true;
+		}
+
+		static bool on_double(void*, long double) {
+			return true;
+		}
+
+		static bool on_string(void*, std::string_view) {
+			return true;
+		}
+
+		static bind_target on_array_begin(void*) {
+			return bind_target{ nullptr, &table };
+		}
+
+		static constexpr bind_handlers table = {
+			value_type::V_NULL, on_null, on_bool, on_char, on_int, on_double, on_string, on_array_begin
+		};
+	};
+
+	std::string build_bind_error_message(std::string_view, value_type, value_type);
+
+	// writes the parser events straight into the fields of a T, the handlers of each field are chosen
+	// at compile time from its type. Keys out of the schema are skipped, and the first value of a
+	// repeated key is kept, as in a std::map
+	template<bound T>
+	class bind_builder {
+	private:
+		static constexpr std::size_t FIELDS = std::tuple_size_v<decltype(schema<T>::fields)>;
+
+		T _object;
+		std::array<bool, FIELDS> _set;
+
+		std::string _key;
+		std::vector<bind_target> _targets;
+
+		template<std::size_t I>
+		bool match(std::string_view, bind_target&);
+		template<std::size_t... I>
+		bind_target find(std::string_view, std::index_sequence<I...>);
+
+		[[noreturn]] void invalid_value(value_type) const;
+
+	public:
+		using document_type = T;
+
+		void reset();
+		T take();
+
+		void on_key(std::string_view);
+		void on_null();
+		void on_bool(bool);
+		void on_char(char);
+		void on_int(long long);
+		void on_float(float);
+		void on_double(double);
+		void on_long_double(long double);
+		void on_string(std::string_view);
+		void on_array_begin();
+		void on_array_end();
+	};
+
+	template<bound T>
+	using bind_parser = basic_parser<bind_builder<T>>;
+
+	template<bound T>
+	void bind_builder<T>::reset() {
+		_object = T();
+		_set.fill(false);
+		_targets.clear();
+	}
+
+	template<bound T>
+	T bind_builder<T>::take() {
+		return std::move(_object);
+	}
+
+	template<bound T>
+	template<std::size_t I>
+	bool bind_builder<T>::match(std::string_view key, bind_target& target) {
+		auto& f = std::get<I>(schema<T>::fields);
+		if (f.key != key) {
+			return false;
+		}
+		if (!_set[I]) {
+			_set[I] = true;
+			auto& member = _object.*(f.member);
+			target = bind_target{ &member, &bind_value<std::remove_cvref_t<decltype(member)>>::table };
+		}
+		return true;
+	}
+
+	template<bound T>
+	template<std::size_t... I>
+	bind_target bind_builder<T>::find(std::string_view key, std::index_sequence<I...>) {
+		auto target = bind_target{ nullptr, &bind_ignore::table };
+		(match<I>(key, target) or ...);
+		return target;
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_key(std::string_view key) {
+		_key = key;
+		_targets.clear();
+		_targets.push_back(find(key, std::make_index_sequence<FIELDS>()));
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_null() {
+		auto& t = _targets.back();
+		if (!t.handlers->on_null(t.object)) {
+			invalid_value(value_type::V_NULL);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_bool(bool v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_bool(t.object, v)) {
+			invalid_value(value_type::V_BOOL);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_char(char v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_char(t.object, v)) {
+			invalid_value(value_type::V_CHAR);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_int(long long v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_int(t.object, v)) {
+			invalid_value(value_type::V_INT);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_float(float v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_double(t.object, v)) {
+			invalid_value(value_type::V_FLOAT);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_double(double v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_double(t.object, v)) {
+			invalid_value(value_type::V_DOUBLE);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_long_double(long double v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_double(t.object, v)) {
+			invalid_value(value_type::V_DOUBLE);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_string(std::string_view v) {
+		auto& t = _targets.back();
+		if (!t.handlers->on_string(t.object, v)) {
+			invalid_value(value_type::V_STRING);
+		}
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_array_begin() {
+		auto& t = _targets.back();
+		auto items = t.handlers->on_array_begin(t.object);
+		if (items.handlers == nullptr) {
+			invalid_value(value_type::V_ARRAY);
+		}
+		_targets.push_back(items);
+	}
+
+	template<bound T>
+	void bind_builder<T>::on_array_end() {
+		_targets.pop_back();
+	}
+
+	template<bound T>
+	void bind_builder<T>::invalid_value(value_type type) const {
+		throw std::invalid_argument(build_bind_error_message(_key, type, _targets.back().handlers->type));
+	}
+
+	// writes a bound member as a plain text value
+	template<class M>
+	void write_bound_value(const M& v, std::string& output) {
+		if constexpr (std::is_same_v<M, bool>) {
+			output += v ? "true" : "false";
+		}
+		else if constexpr (std::is_same_v<M, char>) {
+			write_char(v, output);
+		}
+		else if constexpr (std::is_arithmetic_v<M>) {
+			write_number(v, output);
+		}
+		else if constexpr (std::is_same_v<M, std::string>) {
+			write_string(v, output);
+		}
+		else {
+			output += '[';
+			for (auto i = std::size_t(0); i < v.size(); ++i) {
+				if (i > 0) {
+					output += ',';
+				}
+				write_bound_value<typename M::value_type>(v[i], output);
+			}
+			output += ']';
+		}
+	}
+
+	// appends the plain text of the fields of object to output, in the order of its schema
+	template<bound T>
+	void write_bound(const T& object, std::string& output) {
+		std::apply([&](const auto&... fields) {
+			((output += fields.key, output += ':', write_bound_value(object.*(fields.member), output), output += ";\n"), ...);
+		}, schema<T>::fields);
+	}
+
+}
@@ -11,7 +11,7 @@ namespace bps_core {
 		return category == other.category && image == other.image && line == other.line && collumn == other.collumn;
 	}
 
-	bool bps_core::is_skip(char c) {
+	bool is_skip(char c) {
 		auto fc = std::find(std::begin(skip), std::end(skip), c);
 		return fc != std::end(skip);
 	}
@@ -27,191 +27,393 @@ namespace bps_core {
 		return msg.str();
 	}
 
-	std::vector<token> lexer::_tokens;
-	std::string lexer::_input;
-	char lexer::_curr_char;
-	int lexer::_curr_index;
-	int lexer::_curr_line;
-	int lexer::_curr_collumn;
+	syntax_error::syntax_error(const std::string& message, int line, int collumn)
+		: std::invalid_argument(message), _line(line), _collumn(collumn) {
+	}
+
+	int syntax_error::line() const noexcept {
+		return _line;
+	}
+
+	int syntax_error::collumn() const noexcept {
+		return _collumn;
+	}
+
+	void decode_string(std::string_view content, std::string& out) {
+		auto before_char = (char)symbols::DQUOTE;
+		for (auto c : content) {
+			if (c != '\\' or before_char == '\\') {
+				out += c;
+			}
+			before_char = c;
+		}
+	}
+
+	char decode_char(std::string_view content) {
+		for (auto c : content) {
+			if (c != '\\') {
+				return c;
+			}
+		}
+		return '\0';
+	}
 
 	void lexer::init() {
-		_tokens = std::vector<token>();
 		_curr_index = 0;
-		_curr_line = 1;
-		_curr_collumn = 1;
+		_block_index = std::numeric_limits<std::size_t>::max();
+		_location_index = 0;
+		_location_line = 1;
+		_location_line_start = 0;
+	}
+
+	metrics& metrics::operator+=(const metrics& other) {
+		documents += other.documents;
+		bytes_read += other.bytes_read;
+		bytes_written += other.bytes_written;
+		for (auto i = std::size_t(0); i < tokens.size(); ++i) {
+			tokens[i] += other.tokens[i];
+		}
+		max_depth = std::max(max_depth, other.max_depth);
+		allocations += other.allocations;
+		lex_time += other.lex_time;
+		parse_time += other.parse_time;
+		build_time += other.build_time;
+		serialize_time += other.serialize_time;
+		return *this;
+	}
+
+	void instrumentation::report(const metrics& call) const {
+		if (counters != nullptr) {
+			*counters += call;
+		}
+		if (callback) {
+			callback(call);
+		}
+	}
+
+
+	std::vector<token> lexer::tokenize(std::string_view input) {
+		auto tokens = std::vector<token>();
+		auto tok = token_view();
+
+		auto call = metrics();
+		auto begin = std::chrono::steady_clock::time_point();
+		if (_instrumentation != nullptr) {
+			if (_instrumentation->allocation_count) {
+				call.allocations = _instrumentation->allocation_count();
+			}
+			begin = std::chrono::steady_clock::now();
+		}
+
+		load(input);
+		do {
+			next_token(tok);
+
+			auto lexeme = image(tok);
+			auto& t = tokens.emplace_back();
+			t.category = tok.category;
+			switch (tok.category) {
+			case token_category::T_EOF:
+				t.line = -1;
+				t.collumn = -1;
+				continue;
+			case token_category::T_STRING:
+				t.image += symbols::DQUOTE;
+				decode_string(lexeme.substr(1, lexeme.length() - 2), t.image);
+				t.image += symbols::DQUOTE;
+				break;
+			case token_category::T_INTEGER:
+			case token_category::T_FLOAT:
+				t.image = lexeme;
+				std::transform(t.image.begin(), t.image.end(), t.image.begin(), ::tolower);
+				break;
+			default:
+				t.image = lexeme;
+			}
+			location(tok.offset, t.line, t.collumn);
+		} while (tok.category != token_category::T_EOF);
+
+		if (_instrumentation != nullptr) {
+			call.lex_time = std::chrono::steady_clock::now() - begin;
+			call.documents = 1;
+			call.bytes_read = input.length();
+			for (auto& t : tokens) {
+				++call.tokens[t.category];
+			}
+			if (_instrumentation->allocation_count) {
+				call.allocations = _instrumentation->allocation_count() - call.allocations;
+			}
+			_instrumentation->report(call);
+		}
+		return tokens;
 	}
 
-	std::vector<token> lexer::tokenize(std::string input) {
+	void lexer::set_instrumentation(const instrumentation* instrumentation) {
+		_instrumentation = instrumentation;
+	}
+
+	void lexer::load(std::string_view input, int line, int collumn) {
 		init();
 		_input = input;
+		_origin_line = line;
+		_origin_collumn = collumn;
+	}
+
+	void lexer::seek(std::size_t index) {
+		_curr_index = std::min(index, _input.length());
+	}
+
+	void lexer::next_token(token_view& tok) {
+		const auto size = _input.length();
 
-		next_char();
-		while (!end_of_input()) {
-			// to skip the skip chars
-			if (is_skip(_curr_char)) {
-				if (_curr_char == symbols::NEWLINE) {
-					next_line();
+		while (true) {
+			// to skip the skip chars, chars above space are never skipped
+			if (_curr_index >= size or (unsigned char)_input[_curr_index] <= symbols::SPACE) {
+				_curr_index = skip_while(_curr_index, &block_masks::whitespace);
+				if (_curr_index >= size) {
+					break;
 				}
-				next_char();
-				continue;
 			}
 
+			auto curr_char = _input[_curr_index];
+
 			// to skip comments
-			if (_curr_char == HASH) {
-				while (!end_of_input() and _curr_char != symbols::NEWLINE) {
-					next_char();
-				}
-				next_line();
-				next_char();
+			if (curr_char == HASH) {
+				auto newline = _input.find(symbols::NEWLINE, _curr_index);
+				_curr_index = newline == std::string_view::npos ? size : newline + 1;
+				continue;
 			}
-			// key, boolean or null
-			else if (std::isalpha(_curr_char) or _curr_char == symbols::UNDERSCORE) {
-				auto lexeme = std::string(&_curr_char);
-				auto init_col = _curr_collumn;
-				next_char();
 
+			auto init_index = _curr_index;
+			auto category = token_category::T_EOF;
+
+			// key, boolean or null
+			if (std::isalpha((unsigned char)curr_char) or curr_char == symbols::UNDERSCORE) {
 				// loops the key
-				while (!end_of_input() and _curr_char != symbols::COLON and (_curr_char == symbols::UNDERSCORE or std::isalnum(_curr_char))) {
-					lexeme += _curr_char;
-					next_char();
-				}
+				_curr_index = skip_while(_curr_index + 1, &block_masks::ident);
 
+				auto lexeme = _input.substr(init_index, _curr_index - init_index);
 				// true or false
 				if (lexeme == "true" or lexeme == "false") {
-					_tokens.push_back(token(token_category::T_BOOL, lexeme, _curr_line, init_col));
+					category = token_category::T_BOOL;
 				}
 				// null 
 				else if (lexeme == "null") {
-					_tokens.push_back(token(token_category::T_NULL, lexeme, _curr_line, init_col));
+					category = token_category::T_NULL;
 				}
 				// key
 				else {
-					_tokens.push_back(token(token_category::T_KEY, lexeme, _curr_line, init_col));
+					category = token_category::T_KEY;
 				}
 			}
 			// open array
-			else if (_curr_char == symbols::LEFT_BRACKETS) {
-				_tokens.push_back(token(token_category::T_OPEN_ARRAY, std::string(&_curr_char), _curr_line, _curr_collumn));
-				next_char();
+			else if (curr_char == symbols::LEFT_BRACKETS) {
+				category = token_category::T_OPEN_ARRAY;
+				++_curr_index;
 			}
 			// close array
-			else if (_curr_char == symbols::RIGHT_BRACKETS) {
-				_tokens.push_back(token(token_category::T_CLOSE_ARRAY, std::string(&_curr_char), _curr_line, _curr_collumn));
-				next_char();
+			else if (curr_char == symbols::RIGHT_BRACKETS) {
+				category = token_category::T_CLOSE_ARRAY;
+				++_curr_index;
 			}
 			// end of data
-			else if (_curr_char == symbols::SEMICOLON) {
-				_tokens.push_back(token(token_category::T_END_OF_DATA, std::string(&_curr_char), _curr_line, _curr_collumn));
-				next_char();
+			else if (curr_char == symbols::SEMICOLON) {
+				category = token_category::T_END_OF_DATA;
+				++_curr_index;
 			}
 			// array sep
-			else if (_curr_char == symbols::COMMA) {
-				_tokens.push_back(token(token_category::T_ARRAY_SEP, std::string(&_curr_char), _curr_line, _curr_collumn));
-				next_char();
+			else if (curr_char == symbols::COMMA) {
+				category = token_category::T_ARRAY_SEP;
+				++_curr_index;
 			}
 			// data sep
-			else if (_curr_char == symbols::COLON) {
-				_tokens.push_back(token(token_category::T_DATA_SEP, std::string(&_curr_char), _curr_line, _curr_collumn));
-				next_char();
+			else if (curr_char == symbols::COLON) {
+				category = token_category::T_DATA_SEP;
+				++_curr_index;
 			}
 			// string
-			else if (_curr_char == symbols::DQUOTE) {
-				auto lexeme = std::string(&_curr_char);
-				auto init_col = _curr_collumn;
-				auto before_char = _curr_char;
-				next_char();
-				while (!end_of_input() and (_curr_char != symbols::DQUOTE or before_char == '\\')) {
-					if (_curr_char != '\\' or before_char == '\\') {
-						lexeme += _curr_char;
-					}
-					before_char = _curr_char;
-					next_char();
+			else if (curr_char == symbols::DQUOTE) {
+				_curr_index = find_string_end(_curr_index + 1);
+				if (_curr_index >= size) {
+					error("String was not closed", size - 1);
 				}
-				if (_curr_char != symbols::DQUOTE) {
-					throw std::invalid_argument(build_lexer_error_message("String was not closed", _curr_line, _curr_collumn));
-				}
-				lexeme += _curr_char;
-				_tokens.push_back(token(token_category::T_STRING, lexeme, _curr_line, init_col));
-				next_char();
+				category = token_category::T_STRING;
+				++_curr_index;
 			}
 			// char
-			else if (_curr_char == symbols::QUOTE) {
-				auto lexeme = std::string(&_curr_char);
-				auto init_col = _curr_collumn;
-				next_char();
-				if (_curr_char == '\\') {
-					lexeme += _curr_char;
-					next_char();
+			else if (curr_char == symbols::QUOTE) {
+				++_curr_index;
+				if (_curr_index < size and _input[_curr_index] == '\\') {
+					++_curr_index;
 				}
-				lexeme += _curr_char;
-				next_char();
-				if (_curr_char != symbols::QUOTE) {
-					throw std::invalid_argument(build_lexer_error_message("Char was not closed", _curr_line, _curr_collumn));
+				++_curr_index;
+				if (_curr_index >= size or _input[_curr_index] != symbols::QUOTE) {
+					error("Char was not closed", std::min(_curr_index, size - 1));
 				}
-				lexeme += _curr_char;
-				_tokens.push_back(token(token_category::T_CHAR, lexeme, _curr_line, init_col));
-				next_char();
+				category = token_category::T_CHAR;
+				++_curr_index;
 			}
 			// numeric
-			else if (std::isdigit(_curr_char) or _curr_char == symbols::DOT or _curr_char == symbols::MINUS) {
-				auto lexeme = std::string(&_curr_char);
-				auto init_col = _curr_collumn;
-				auto dotted = _curr_char == symbols::DOT;
-				next_char();
-				while (!end_of_input() and (std::isdigit(_curr_char) or _curr_char == symbols::DOT)) {
-					if (_curr_char == symbols::DOT) {
+			else if (std::isdigit((unsigned char)curr_char) or curr_char == symbols::DOT or curr_char == symbols::MINUS) {
+				_curr_index = skip_while(_curr_index + 1, &block_masks::number);
+
+				auto dotted = false;
+				for (auto i = init_index; i < _curr_index; ++i) {
+					if (_input[i] == symbols::DOT) {
 						if (dotted) {
-							throw std::invalid_argument(build_lexer_error_message("Double dot encountered", _curr_line, _curr_collumn));
-						}
-						else {
-							dotted = true;
+							error("Double dot encountered", i);
 						}
+						dotted = true;
 					}
-					lexeme += _curr_char;
-					next_char();
 				}
-				if (std::tolower(_curr_char) == 'f' or std::tolower(_curr_char) == 'd') {
-					lexeme += _curr_char;
-					next_char();
+				auto suffix = _curr_index < size ? std::tolower((unsigned char)_input[_curr_index]) : 0;
+				if (suffix == 'f' or suffix == 'd') {
+					++_curr_index;
 				}
-				std::transform(lexeme.begin(), lexeme.end(), lexeme.begin(), ::tolower);
 				// float or int
-				if (lexeme.find(symbols::DOT) != std::string::npos or lexeme.find('f') != std::string::npos) {
-					_tokens.push_back(token(token_category::T_FLOAT, lexeme, _curr_line, init_col));
+				if (dotted or suffix == 'f') {
+					category = token_category::T_FLOAT;
 				}
 				else {
-					_tokens.push_back(token(token_category::T_INTEGER, lexeme, _curr_line, init_col));
+					category = token_category::T_INTEGER;
 				}
 			}
 			else {
 				std::stringstream msg;
 				msg << "Invalid character '";
-				msg << _curr_char;
+				msg << curr_char;
 				msg << "' encountered";
-				throw std::invalid_argument(build_lexer_error_message(msg.str(), _curr_line, _curr_collumn));
+				error(msg.str(), _curr_index);
 			}
+
+			set_token(tok, category, init_index);
+			return;
 		}
 
-		_tokens.push_back(token(token_category::T_EOF, std::string(), -1, -1));
+		set_token(tok, token_category::T_EOF, size);
+	}
 
-		return _tokens;
+	const block_masks& lexer::block_at(std::size_t index) {
+		auto block_index = index - index % BLOCK_SIZE;
+		if (block_index != _block_index) {
+			scan_block(_input, block_index, _block);
+			_block_index = block_index;
+		}
+		return _block;
+	}
+
+	std::size_t lexer::skip_while(std::size_t index, std::uint64_t block_masks::* mask) {
+		// jumps to the first char out of the mask, a whole block at a time
+		while (index < _input.length()) {
+			auto offset = index % BLOCK_SIZE;
+			auto outside = ~(block_at(index).*mask) >> offset;
+			if (outside != 0) {
+				return std::min(index + std::countr_zero(outside), _input.length());
+			}
+			index += BLOCK_SIZE - offset;
+		}
+		return _input.length();
+	}
+
+	std::size_t lexer::find_string_end(std::size_t index) {
+		while (index < _input.length()) {
+			auto offset = index % BLOCK_SIZE;
+			auto block_index = index - offset;
+			auto carry = block_index > 0 and _input[block_index - 1] == '\\';
+			auto quotes = unescaped_quotes(block_at(index), carry) >> offset;
+			if (quotes != 0) {
+				return index + std::countr_zero(quotes);
+			}
+			index += BLOCK_SIZE - offset;
+		}
+		return _input.length();
 	}
 
-	bool lexer::end_of_input() {
-		return _curr_index > _input.length();
+	std::string_view lexer::image(const token_view& tok) const {
+		return _input.substr(tok.offset, tok.length);
 	}
 
-	void lexer::next_line() {
-		++_curr_line;
-		_curr_collumn = 0;
+	void lexer::location(std::size_t index, int& line, int& collumn) {
+		// newlines are counted only on demand, resuming from the last location asked for
+		if (index < _location_index) {
+			_location_index = 0;
+			_location_line = 1;
+			_location_line_start = 0;
+		}
+		for (; _location_index < index and _location_index < _input.length(); ++_location_index) {
+			if (_input[_location_index] == symbols::NEWLINE) {
+				++_location_line;
+				_location_line_start = _location_index + 1;
+			}
+		}
+		line = _location_line + _origin_line - 1;
+		collumn = (int)(index - _location_line_start) + 1;
+		if (_location_line == 1) {
+			collumn += _origin_collumn - 1;
+		}
 	}
 
-	void lexer::next_char() {
-		if (_curr_index < _input.length()) {
-			_curr_char = _input[_curr_index];
-			++_curr_collumn;
+	void lexer::set_token(token_view& tok, token_category category, std::size_t init_index) {
+		if (_curr_index - init_index > std::numeric_limits<std::uint32_t>::max()) {
+			error("Token too long", init_index);
+		}
+		tok.category = category;
+		tok.length = (std::uint32_t)(_curr_index - init_index);
+		tok.offset = init_index;
+	}
+
+	void lexer::error(std::string problem, std::size_t index) {
+		int line, collumn;
+		location(index, line, collumn);
+		throw syntax_error(build_lexer_error_message(problem, line, collumn), line, collumn);
+	}
+
+
+	bool scan_value(lexer& lex, token_view& tok) {
+		// arrays are skipped by matching their brackets, their items are only checked to be constants
+		auto depth = 0;
+		auto expect_value = true;
+		// whether the array just opened has no value yet
+		auto empty = false;
+		while (tok.category != token_category::T_EOF and tok.category != token_category::T_END_OF_DATA) {
+			auto valid = false;
+			switch (tok.category) {
+			case token_category::T_OPEN_ARRAY:
+				valid = expect_value;
+				++depth;
+				expect_value = true;
+				empty = true;
+				break;
+			case token_category::T_CLOSE_ARRAY:
+				valid = depth > 0 and (!expect_value or empty);
+				--depth;
+				expect_value = false;
+				empty = false;
+				break;
+			case token_category::T_ARRAY_SEP:
+				valid = depth > 0 and !expect_value;
+				expect_value = true;
+				empty = false;
+				break;
+			case token_category::T_STRING:
+			case token_category::T_CHAR:
+			case token_category::T_INTEGER:
+			case token_category::T_FLOAT:
+			case token_category::T_BOOL:
+			case token_category::T_NULL:
+				valid = expect_value;
+				expect_value = false;
+				empty = false;
+				break;
+			default:
+				break;
+			}
+			if (!valid) {
+				return false;
+			}
+			lex.next_token(tok);
 		}
-		++_curr_index;
+		return !expect_value and depth == 0 and tok.category == token_category::T_END_OF_DATA;
 	}
 
 
@@ -229,276 +431,156 @@ namespace bps_core {
 		return msg.str();
 	}
 
-	std::map<std::string, std::any> parser::_parsed_data;
-	std::vector<token> parser::_tokens;
-	token parser::_curr_token;
-	int parser::_curr_index;
-	std::string parser::_key;
-	std::any parser::_value;
-	std::stack<std::vector<std::any>*> parser::_arr_stack;
-	const int parser::CONTEXT_KEY = 0;
-	const int parser::CONTEXT_ARRAY = 1;
-	int parser::_context = CONTEXT_KEY;
-
-	void parser::init() {
-		_parsed_data = std::map<std::string, std::any>();
-		_curr_index = -1;
-		_arr_stack = std::stack<std::vector<std::any>*>();
-		_context = CONTEXT_KEY;
-	}
-
-	std::map<std::string, std::any> parser::parse(std::string data) {
-		init();
-		_tokens = lexer::tokenize(data);
-		start();
-		return _parsed_data;
-	}
+	void write_string(std::string_view str, std::string& output) {
+		output.reserve(output.length() + str.length() + 2);
+		output += '"';
+
+		// quotes are found a block at a time, the chars between them are copied at once
+		auto start = std::size_t(0);
+		auto masks = block_masks();
+		for (auto index = std::size_t(0); index < str.length(); index += BLOCK_SIZE) {
+			scan_block(str, index, masks);
+			for (auto quotes = masks.dquote; quotes != 0; quotes &= quotes - 1) {
+				auto quote = index + std::countr_zero(quotes);
+				output.append(str.data() + start, quote - start);
+				output += "\\\"";
+				start = quote + 1;
+			}
+		}
+		output.append(str.data() + start, str.length() - start);
 
-	void parser::start() {
-		next_token();
-		statement();
-		consume_token(token_category::T_EOF);
+		output += '"';
 	}
 
-	void parser::statement() {
-		switch (_curr_token.category) {
-		case token_category::T_KEY:
-			key();
-			break;
-		default:
-			break;
+	void write_char(char c, std::string& output) {
+		output += '\'';
+		if (c == '\'') {
+			output += '\\';
 		}
+		output += c;
+		output += '\'';
 	}
 
-	void parser::key() {
-		_key = _curr_token.image;
-		next_token();
-		consume_token(token_category::T_DATA_SEP);
-		value();
-		consume_token(token_category::T_END_OF_DATA);
-		statement();
+	template<class Document>
+	std::string plain::parse_document(const Document& data) {
+		_buffer.clear();
+		write(data, _buffer);
+		return _buffer;
 	}
 
-	void parser::value() {
-		switch (_curr_token.category) {
-		case token_category::T_OPEN_ARRAY:
-			tarray();
-			break;
-		case token_category::T_STRING:
-			tstring();
-			break;
-		case token_category::T_CHAR:
-			tchar();
-			break;
-		case token_category::T_INTEGER:
-			tinteger();
-			break;
-		case token_category::T_FLOAT:
-			tfloat();
-			break;
-		case token_category::T_BOOL:
-			tbool();
-			break;
-		case token_category::T_NULL:
-			tnull();
-			break;
-		default:
-			build_parser_error_message(_curr_token.image, _curr_token.line, _curr_token.collumn, "a value or array");
+	template<class Document>
+	void plain::write_document(const Document& data, std::string& output) {
+		auto call = metrics();
+		auto begin = std::chrono::steady_clock::time_point();
+		auto start = output.length();
+		if (_instrumentation != nullptr) {
+			if (_instrumentation->allocation_count) {
+				call.allocations = _instrumentation->allocation_count();
+			}
+			begin = std::chrono::steady_clock::now();
 		}
 
-		if (_context == CONTEXT_ARRAY) {
-			array_selector();
+		// loops bps file adding each key-value to output
+		for (auto& d : data) {
+			output += d.first;
+			output += ':';
+			write_value(d.second, output);
+			output += ";\n";
 		}
-	}
 
-	void parser::array_selector() {
-		switch (_curr_token.category) {
-		case token_category::T_ARRAY_SEP:
-			next_token();
-			value();
-			break;
-		case token_category::T_CLOSE_ARRAY:
-			close_array();
-			next_token();
-			array_selector();
-			break;
-		case token_category::T_END_OF_DATA:
-		case token_category::T_EOF:
-			break;
-		default:
-			build_parser_error_message(_curr_token.image, _curr_token.line, _curr_token.collumn, "',', ']' or ';'");
+		if (_instrumentation != nullptr) {
+			call.serialize_time = std::chrono::steady_clock::now() - begin;
+			call.documents = 1;
+			call.bytes_written = output.length() - start;
+			if (_instrumentation->allocation_count) {
+				call.allocations = _instrumentation->allocation_count() - call.allocations;
+			}
+			_instrumentation->report(call);
 		}
 	}
 
-	void parser::tarray() {
-		open_array();
-		next_token();
-		value();
-	}
-
-	void parser::tstring() {
-		std::string strValue = _curr_token.image.substr(1, _curr_token.image.length() - 2);
-		_value = strValue;
-		set_value();
-	}
-
-	void parser::tchar() {
-		std::string val = _curr_token.image.substr(1, _curr_token.image.length() - 2);
-		val = std::regex_replace(val, std::regex("\\\\"), "");
-		char cValue = val[0];
-		_value = cValue;
-		set_value();
-	}
-
-	void parser::tinteger() {
-		long long int intValue = std::stoll(_curr_token.image);
-		_value = intValue;
-		set_value();
-	}
-
-	void parser::tfloat() {
-		auto image = _curr_token.image;
-		std::transform(image.begin(), image.end(), image.begin(), ::tolower);
-		auto strValue = image.length() > 0 and image.back() == 'f' ? image.substr(0, image.length() - 1) : image;
-		long double floatValue = std::stold(strValue);
-		_value = floatValue;
-		set_value();
+	void plain::set_instrumentation(const instrumentation* instrumentation) {
+		_instrumentation = instrumentation;
 	}
 
-	void parser::tbool() {
-		bool boolValue = _curr_token.image == "true";
-		_value = boolValue;
-		set_value();
+	std::string plain::parse(const std::map<std::string, std::any>& data) {
+		return parse_document(data);
 	}
 
-	void parser::tnull() {
-		_value = nullptr;
-		set_value();
+	std::string plain::parse(const std::map<std::string, value>& data) {
+		return parse_document(data);
 	}
 
-	void parser::set_value() {
-		if (_context == CONTEXT_ARRAY) {
-			_arr_stack.top()->push_back(_value);
-		}
-		else {
-			_parsed_data.emplace(_key, _value);
-		}
-		next_token();
+	std::string plain::parse(const flat_map<std::any>& data) {
+		return parse_document(data);
 	}
 
-	void parser::open_array() {
-		if (_arr_stack.size() == 0) {
-			_context = CONTEXT_ARRAY;
-			_arr_stack.push(new std::vector<std::any>());
-		}
-		else {
-			auto newDimension = new std::vector<std::any>();
-			_arr_stack.push(newDimension);
-		}
+	std::string plain::parse(const flat_map<value>& data) {
+		return parse_document(data);
 	}
 
-	void parser::close_array() {
-		if (_arr_stack.size() > 1) {
-			std::vector<std::any>* arr = _arr_stack.top();
-			_arr_stack.pop();
-			_arr_stack.top()->push_back(*arr);
-		}
-		else {
-			_context = CONTEXT_KEY;
-			_parsed_data.emplace(_key, *_arr_stack.top());
-			_arr_stack.pop();
-		}
+	void plain::write(const std::map<std::string, std::any>& data, std::string& output) {
+		write_document(data, output);
 	}
 
-	void parser::next_token() {
-		if (++_curr_index < _tokens.size()) {
-			_curr_token = _tokens[_curr_index];
-		}
+	void plain::write(const std::map<std::string, value>& data, std::string& output) {
+		write_document(data, output);
 	}
 
-	void parser::consume_token(token_category category) {
-		if (_curr_token.category != category) {
-			build_parser_error_message(_curr_token.image, _curr_token.line, _curr_token.collumn, TOKEN_IMAGE[(int)category]);
-		}
-		next_token();
+	void plain::write(const flat_map<std::any>& data, std::string& output) {
+		write_document(data, output);
 	}
 
-
-	std::stringstream plain::_plain_string_builder;
-
-	void plain::init() {
-		_plain_string_builder = std::stringstream();
+	void plain::write(const flat_map<value>& data, std::string& output) {
+		write_document(data, output);
 	}
 
-	std::string plain::parse(std::map<std::string, std::any> data) {
-		init();
-
-		// loops bps file adding each key-value to output
-		for (auto d : data) {
-			_plain_string_builder << d.first;
-			_plain_string_builder << ":";
-			parse_value(d.second);
-			_plain_string_builder << ";" << std::endl;
-		}
-
-		return _plain_string_builder.str();
-	}
-
-	void plain::parse_value(std::any value) {
+	void plain::write_value(const std::any& value, std::string& output) {
 		// null values
 		if (value.type() == typeid(nullptr)) {
-			_plain_string_builder << "null";
+			output += "null";
 		}
 		// value is an array
 		else if (value.type() == typeid(std::vector<std::any>)) {
-			_plain_string_builder << "[";
-			parse_array(std::any_cast<std::vector<std::any>>(value));
-			_plain_string_builder << "]";
+			output += '[';
+			write_array(*std::any_cast<std::vector<std::any>>(&value), output);
+			output += ']';
+		}
+		else if (value.type() == typeid(typed_array)) {
+			auto index = std::size_t(0);
+			write_typed(*std::any_cast<typed_array>(&value), 0, index, output);
 		}
 		// it's a normal value
 		else {
 			if (value.type() == typeid(std::string)) {
-				_plain_string_builder << "\"";
-				_plain_string_builder << std::regex_replace(std::any_cast<std::string>(value), std::regex("\""), "\\\"");
-				_plain_string_builder << "\"";
+				write_string(*std::any_cast<std::string>(&value), output);
 			}
 			else if (value.type() == typeid(char)) {
-				char c = std::any_cast<char>(value);
-				_plain_string_builder << "'";
-				if (c == '\'') {
-					_plain_string_builder << "\\";
-				}
-				_plain_string_builder << c;
-				_plain_string_builder << "'";
+				write_char(std::any_cast<char>(value), output);
 			}
 			else if (value.type() == typeid(bool)) {
-				if (std::any_cast<bool>(value)) {
-					_plain_string_builder << "true";
-				}
-				else {
-					_plain_string_builder << "false";
-				}
+				output += std::any_cast<bool>(value) ? "true" : "false";
 			}
 			else if (value.type() == typeid(float)) {
-				_plain_string_builder << std::any_cast<float>(value);
+				write_number(std::any_cast<float>(value), output);
 			}
 			else if (value.type() == typeid(double)) {
-				_plain_string_builder << std::any_cast<double>(value);
+				write_number(std::any_cast<double>(value), output);
 			}
 			else if (value.type() == typeid(long double)) {
-				_plain_string_builder << std::any_cast<long double>(value);
+				write_number(std::any_cast<long double>(value), output);
 			}
 			else if (value.type() == typeid(short)) {
-				_plain_string_builder << std::any_cast<short>(value);
+				write_number(std::any_cast<short>(value), output);
 			}
 			else if (value.type() == typeid(int)) {
-				_plain_string_builder << std::any_cast<int>(value);
+				write_number(std::any_cast<int>(value), output);
 			}
 			else if (value.type() == typeid(long)) {
-				_plain_string_builder << std::any_cast<long>(value);
+				write_number(std::any_cast<long>(value), output);
 			}
 			else if (value.type() == typeid(long long)) {
-				_plain_string_builder << std::any_cast<long long>(value);
+				write_number(std::any_cast<long long>(value), output);
 			}
 			else {
 				std::stringstream msg;
@@ -510,14 +592,102 @@ namespace bps_core {
 		}
 	}
 
-	void plain::parse_array(std::vector<std::any> vector) {
+	void plain::write_array(const std::vector<std::any>& vector, std::string& output) {
 		// loops each value in array
-		for (auto i = 0; i < vector.size(); ++i) {
-			parse_value(vector[i]);
+		for (auto i = std::size_t(0); i < vector.size(); ++i) {
+			write_value(vector[i], output);
 			if (i < vector.size() - 1) {
-				_plain_string_builder << ",";
+				output += ',';
+			}
+		}
+	}
+
+	void plain::write_value(const value& v, std::string& output) {
+		switch (v.type()) {
+		case value_type::V_NULL:
+			output += "null";
+			break;
+		case value_type::V_ARRAY:
+			output += '[';
+			write_array(v.as_array(), output);
+			output += ']';
+			break;
+		case value_type::V_TYPED_ARRAY: {
+			auto index = std::size_t(0);
+			write_typed(v.as_typed_array(), 0, index, output);
+			break;
+		}
+		case value_type::V_STRING:
+			write_string(v.as_string(), output);
+			break;
+		case value_type::V_CHAR:
+			write_char(v.as_char(), output);
+			break;
+		case value_type::V_BOOL:
+			output += v.as_bool() ? "true" : "false";
+			break;
+		case value_type::V_INT:
+			write_number(v.as_int(), output);
+			break;
+		case value_type::V_FLOAT:
+			write_number(v.as_float(), output);
+			break;
+		case value_type::V_DOUBLE:
+			write_number(v.as_double(), output);
+			break;
+		}
+	}
+
+	void plain::write_array(const value::array_type& vector, std::string& output) {
+		// loops each value in array
+		for (auto i = std::size_t(0); i < vector.size(); ++i) {
+			write_value(vector[i], output);
+			if (i < vector.size() - 1) {
+				output += ',';
+			}
+		}
+	}
+
+
+	void plain::write_typed(const typed_array& arr, std::size_t dimension, std::size_t& index, std::string& output) {
+		auto shape = arr.shape();
+		auto length = shape[dimension];
+
+		output += '[';
+		if (dimension + 1 < shape.size()) {
+			for (auto i = std::size_t(0); i < length; ++i) {
+				if (i > 0) {
+					output += ',';
+				}
+				write_typed(arr, dimension + 1, index, output);
+			}
+		}
+		else {
+			// the innermost dimension is a run of contiguous items
+			auto write_items = [&](auto items, auto write_item) {
+				for (auto i = std::size_t(0); i < length; ++i) {
+					if (i > 0) {
+						output += ',';
+					}
+					write_item(items[index + i]);
+				}
+			};
+			switch (arr.type()) {
+			case value_type::V_BOOL:
+				write_items(arr.as_span<bool>(), [&](bool v) { output += v ? "true" : "false"; });
+				break;
+			case value_type::V_INT:
+				write_items(arr.as_span<std::int64_t>(), [&](std::int64_t v) { write_number(v, output); });
+				break;
+			case value_type::V_DOUBLE:
+				write_items(arr.as_span<double>(), [&](double v) { write_number(v, output); });
+				break;
+			default:
+				write_items(arr.as_span<std::string>(), [&](const std::string& v) { write_string(v, output); });
 			}
+			index += length;
 		}
+		output += ']';
 	}
 
 }
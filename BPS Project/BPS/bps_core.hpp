@@ -1,6 +1,9 @@
 #pragma once
 
 #include "pch.h"
+#include "bps_value.hpp"
+#include "bps_simd.hpp"
+#include "bps_flat.hpp"
 
 
 namespace bps_core {
@@ -70,101 +73,940 @@ namespace bps_core {
 		bool operator==(const token&) const;
 	};
 
+	// compact token, its lexeme is sliced from the lexer input only when needed
+	struct token_view {
+		token_category category;
+		std::uint32_t length;
+		std::size_t offset;
+	};
+
 	const char skip[] = { SPACE, TAB, NEWLINE, RETURN };
 
 	bool is_skip(char);
 
 	std::string build_lexer_error_message(std::string, int, int);
 
-	static class lexer {
+	// lexical error, with the location of the char that caused it
+	class syntax_error : public std::invalid_argument {
 	private:
-		static std::vector<token> _tokens;
+		int _line;
+		int _collumn;
+
+	public:
+		syntax_error(const std::string&, int, int);
+
+		int line() const noexcept;
+		int collumn() const noexcept;
+	};
 
+	// appends the content of a string literal without its escape chars
+	void decode_string(std::string_view, std::string&);
+
+	// the content of a char literal without its escape char, an escaped backslash decodes to '\0'
+	char decode_char(std::string_view);
+
+	// work done by lexer, parser and plain calls, the times are wall times
+	struct metrics {
+		// documents lexed, parsed or written
+		std::uint64_t documents = 0;
+		std::uint64_t bytes_read = 0;
+		std::uint64_t bytes_written = 0;
+		// tokens read, by token_category
+		std::array<std::uint64_t, T_ARRAY_SEP + 1> tokens = {};
+		int max_depth = 0;
+		// allocations made, only counted with an instrumentation allocation_count
+		std::uint64_t allocations = 0;
+
+		std::chrono::nanoseconds lex_time = {};
+		// time of the grammar itself, without the lex and build times
+		std::chrono::nanoseconds parse_time = {};
+		// time spent in the builder, adding the values to the document
+		std::chrono::nanoseconds build_time = {};
+		std::chrono::nanoseconds serialize_time = {};
+
+		metrics& operator+=(const metrics&);
+	};
+
+	// where lexer, parser and plain report the metrics of each call, once it returns. They only measure
+	// while one is set, without one the cost is a null check per token
+	class instrumentation {
+	public:
+		// counters each call is added to, not synchronized, so each thread needs its own
+		metrics* counters = nullptr;
+		// called with the metrics of each call
+		std::function<void(const metrics&)> callback;
+		// allocations made by the process so far, for applications that count them
+		std::function<std::uint64_t()> allocation_count;
+
+		void report(const metrics&) const;
+	};
+
+	// lexer, parser and plain hold their state per instance: each thread owns its own
+	// instances and reusing one keeps its buffers allocated between calls
+	class lexer {
+	private:
 		// control vars
-		static std::string _input;
-		static char _curr_char;
-		static int _curr_index;
-		static int _curr_line;
-		static int _curr_collumn;
+		std::string_view _input;
+		std::size_t _curr_index;
+
+		// char class masks of the block being read
+		std::size_t _block_index;
+		block_masks _block;
+
+		// last location computed, lines are only counted when a location is asked for
+		std::size_t _location_index;
+		int _location_line;
+		std::size_t _location_line_start;
 
-		static void init();
+		// location of the first input char, for inputs that are a slice of a larger one
+		int _origin_line = 1;
+		int _origin_collumn = 1;
+
+		const instrumentation* _instrumentation = nullptr;
+
+		void init();
 
 	public:
-		static std::vector<token> tokenize(std::string);
+		std::vector<token> tokenize(std::string_view);
+
+		// loads the input to be read token by token through next_token, the input is not copied,
+		// line and collumn are the location of its first char
+		void load(std::string_view, int = 1, int = 1);
+		void next_token(token_view&);
+		// goes on lexing from an index of the input, the chars skipped are not read
+		void seek(std::size_t);
+
+		std::string_view image(const token_view&) const;
+		void location(std::size_t, int&, int&);
+
+		// reports the metrics of each tokenize call, nullptr stops reporting
+		void set_instrumentation(const instrumentation*);
 
 	private:
-		static bool end_of_input();
-		static void next_line();
-		static void next_char();
+		const block_masks& block_at(std::size_t);
+		std::size_t skip_while(std::size_t, std::uint64_t block_masks::*);
+		std::size_t find_string_end(std::size_t);
+
+		void set_token(token_view&, token_category, std::size_t);
+		[[noreturn]] void error(std::string, std::size_t);
 	};
 
 
+	// lexes the value of a statement, from the token after its ':' to its ';'. tok is left on the ';',
+	// or on the first token that does not fit, returns whether the value is well formed
+	bool scan_value(lexer&, token_view&);
+
 	std::string build_parser_error_message(std::string, int, int, std::string);
 
 
-	class parser {
+	// how float constants are stored
+	enum float_mode {
+		// every float as long double
+		F_LONG_DOUBLE = 0,
+		// every float as double
+		F_DOUBLE = 1,
+		// float for constants with the f suffix, double for the others
+		F_NATIVE = 2
+	};
+
+	struct parse_options {
+		float_mode floats = float_mode::F_LONG_DOUBLE;
+		// whether arrays of bools, integers, doubles or strings are stored as typed_array,
+		// with nested arrays of one shape packed into a single typed_array
+		bool typed_arrays = false;
+	};
+
+	// builds the std::any document model from the parser events, into a std::map or a flat_map
+	template<class Document>
+	class basic_any_builder {
+	private:
+		Document _parsed_data;
+
+		std::string _key;
+		std::vector<std::vector<std::any>> _arr_stack;
+
+		bool _typed_arrays = false;
+		std::vector<typed_item> _typed_items;
+
+		void set_value(std::any&&);
+
+	public:
+		using document_type = Document;
+
+		void reset();
+		Document take();
+
+		void set_options(const parse_options&);
+
+		void on_key(std::string_view);
+		void on_null();
+		void on_bool(bool);
+		void on_char(char);
+		void on_int(long long);
+		void on_float(float);
+		void on_double(double);
+		void on_long_double(long double);
+		void on_string(std::string_view);
+		void on_array_begin();
+		void on_array_end();
+	};
+
+	// builds the typed value document model from the parser events, into a std::map or a flat_map
+	template<class Document>
+	class basic_value_builder {
 	private:
-		static std::map<std::string, std::any> _parsed_data;
+		Document _parsed_data;
+
+		std::string _key;
+		std::vector<value> _arr_stack;
+
+		bool _typed_arrays = false;
+		std::vector<typed_item> _typed_items;
+
+		void set_value(value&&);
+
+	public:
+		using document_type = Document;
+
+		void reset();
+		Document take();
+
+		void set_options(const parse_options&);
+
+		void on_key(std::string_view);
+		void on_null();
+		void on_bool(bool);
+		void on_char(char);
+		void on_int(long long);
+		void on_float(float);
+		void on_double(double);
+		void on_long_double(long double);
+		void on_string(std::string_view);
+		void on_array_begin();
+		void on_array_end();
+	};
+
+	using any_builder = basic_any_builder<std::map<std::string, std::any>>;
+	using value_builder = basic_value_builder<std::map<std::string, value>>;
+	using flat_any_builder = basic_any_builder<flat_map<std::any>>;
+	using flat_value_builder = basic_value_builder<flat_map<value>>;
+
+	// recursive descent parser, the document is built by the Builder from the parsed values. The builder
+	// methods are called directly, so each builder gets a parser compiled for its own events
+	template<class Builder>
+	class basic_parser {
+	private:
+		Builder _builder;
 
 		// control vars
-		static std::vector<token> _tokens;
-		static token _curr_token;
-		static int _curr_index;
+		token_view _curr_token;
+		std::string _string_buffer;
+
+		// array nesting depth, 0 while in key context
+		int _depth = 0;
 
-		static std::string _key;
-		static std::any _value;
-		static std::stack<std::vector<std::any>*> _arr_stack;
+		// whether the grammar stopped building the document, later parts are only lexed
+		bool _stopped = false;
 
-		static const int CONTEXT_KEY;
-		static const int CONTEXT_ARRAY;
-		static int _context;
+		// whether a syntax error was skipped over since begin
+		bool _recovered = false;
 
-		static void init();
+		lexer _lexer;
+
+		parse_options _options;
+
+		const instrumentation* _instrumentation = nullptr;
+		// metrics of the parse in progress, nullptr while not instrumented
+		metrics* _metrics = nullptr;
+		metrics _call;
+		std::uint64_t _allocations = 0;
+
+		void init();
+		// parses the loaded input, timing it when instrumented
+		void run();
+		void report();
 
 	public:
-		static std::map<std::string, std::any> parse(std::string);
+		typename Builder::document_type parse(std::string_view);
+
+		// incremental parsing: begin, then parse_part with each slice of input that ends at a
+		// statement boundary, starting at the given line and collumn, then end takes the document
+		void begin();
+		void parse_part(std::string_view, int, int);
+		typename Builder::document_type end();
+
+		Builder& builder() noexcept;
+
+		// whether the parts given so far stopped the grammar or had syntax errors skipped over,
+		// a part that did neither ends right after a complete statement
+		bool stopped() const noexcept;
+		bool recovered() const noexcept;
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+
+		// reports the metrics of each parse, from begin to end, nullptr stops reporting
+		void set_instrumentation(const instrumentation*);
 
 	private:
-		static void start();
+		void start();
 
-		static void statement();
+		void statement();
 
-		static void key();
-		static void value();
+		void key();
+		void value();
 
-		static void tarray();
-		static void array_selector();
+		void tarray();
+		bool array_selector();
 
-		static void tstring();
-		static void tchar();
-		static void tinteger();
-		static void tfloat();
-		static void tdouble();
-		static void tbool();
-		static void tnull();
+		void tstring();
+		void tchar();
+		void tinteger();
+		void tfloat();
+		void tbool();
+		void tnull();
 
-		static void set_value();
+		void open_array();
+		void close_array();
 
-		static void open_array();
-		static void close_array();
+		// calls the builder with event, timing it when instrumented
+		template<class Event>
+		void build(Event&&);
 
 		// parser controls
 
-		static void next_token();
-		static void consume_token(token_category);
+		void next_token();
+		void consume_token(token_category);
+		std::string error_message(std::string);
+		[[noreturn]] void invalid_constant(std::errc);
 	};
 
+	using parser = basic_parser<any_builder>;
+	using value_parser = basic_parser<value_builder>;
+	using flat_parser = basic_parser<flat_any_builder>;
+	using flat_value_parser = basic_parser<flat_value_builder>;
+
+	template<class Document>
+	void basic_any_builder<Document>::reset() {
+		_parsed_data = Document();
+		_arr_stack.clear();
+	}
+
+	template<class Document>
+	Document basic_any_builder<Document>::take() {
+		return std::move(_parsed_data);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::set_options(const parse_options& options) {
+		_typed_arrays = options.typed_arrays;
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_key(std::string_view key) {
+		_key = key;
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_null() {
+		set_value(nullptr);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_bool(bool v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_char(char v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_int(long long v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_float(float v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_double(double v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_long_double(long double v) {
+		set_value(v);
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_string(std::string_view v) {
+		set_value(std::string(v));
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_array_begin() {
+		_arr_stack.emplace_back();
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::on_array_end() {
+		// the finished array is moved into its parent, not copied
+		auto arr = std::move(_arr_stack.back());
+		_arr_stack.pop_back();
+		if (_typed_arrays) {
+			_typed_items.clear();
+			for (auto& item : arr) {
+				_typed_items.push_back(to_typed_item(item));
+			}
+			auto packed = typed_array();
+			if (typed_array::pack(_typed_items, packed)) {
+				set_value(std::move(packed));
+				return;
+			}
+		}
+		set_value(std::move(arr));
+	}
+
+	template<class Document>
+	void basic_any_builder<Document>::set_value(std::any&& value) {
+		if (!_arr_stack.empty()) {
+			_arr_stack.back().push_back(std::move(value));
+		}
+		else {
+			_parsed_data.try_emplace(_key, std::move(value));
+		}
+	}
+
+
+	template<class Document>
+	void basic_value_builder<Document>::reset() {
+		_parsed_data = Document();
+		_arr_stack.clear();
+	}
+
+	template<class Document>
+	Document basic_value_builder<Document>::take() {
+		return std::move(_parsed_data);
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::set_options(const parse_options& options) {
+		_typed_arrays = options.typed_arrays;
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_key(std::string_view key) {
+		_key = key;
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_null() {
+		set_value(value());
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_bool(bool v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_char(char v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_int(long long v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_float(float v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_double(double v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_long_double(long double v) {
+		// values hold doubles at most, see value
+		set_value(value((double)v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_string(std::string_view v) {
+		set_value(value(v));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_array_begin() {
+		_arr_stack.emplace_back(value::array_type());
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::on_array_end() {
+		auto arr = std::move(_arr_stack.back());
+		_arr_stack.pop_back();
+		if (_typed_arrays) {
+			_typed_items.clear();
+			for (auto& item : arr.as_array()) {
+				_typed_items.push_back(to_typed_item(item));
+			}
+			auto packed = typed_array();
+			if (typed_array::pack(_typed_items, packed)) {
+				set_value(value(std::move(packed)));
+				return;
+			}
+		}
+		set_value(std::move(arr));
+	}
+
+	template<class Document>
+	void basic_value_builder<Document>::set_value(value&& v) {
+		if (!_arr_stack.empty()) {
+			_arr_stack.back().as_array().push_back(std::move(v));
+		}
+		else {
+			_parsed_data.try_emplace(_key, std::move(v));
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::init() {
+		_builder.reset();
+		_depth = 0;
+		_stopped = false;
+		_recovered = false;
+
+		_metrics = _instrumentation == nullptr ? nullptr : &_call;
+		if (_metrics != nullptr) {
+			_call = metrics();
+			_call.documents = 1;
+			if (_instrumentation->allocation_count) {
+				_allocations = _instrumentation->allocation_count();
+			}
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::run() {
+		if (_metrics == nullptr) {
+			start();
+			return;
+		}
+		auto begin = std::chrono::steady_clock::now();
+		start();
+		_call.parse_time += std::chrono::steady_clock::now() - begin;
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::report() {
+		if (_metrics == nullptr) {
+			return;
+		}
+		// the lex and build times were measured inside the parse time
+		_call.parse_time -= _call.lex_time + _call.build_time;
+		if (_instrumentation->allocation_count) {
+			_call.allocations = _instrumentation->allocation_count() - _allocations;
+		}
+		_metrics = nullptr;
+		_instrumentation->report(_call);
+	}
+
+	template<class Builder>
+	typename Builder::document_type basic_parser<Builder>::parse(std::string_view data) {
+		init();
+		_lexer.load(data);
+		if (_metrics != nullptr) {
+			_call.bytes_read += data.length();
+		}
+		run();
+		return end();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::begin() {
+		init();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::parse_part(std::string_view data, int line, int collumn) {
+		_lexer.load(data, line, collumn);
+		if (_metrics != nullptr) {
+			_call.bytes_read += data.length();
+		}
+		run();
+	}
+
+	template<class Builder>
+	typename Builder::document_type basic_parser<Builder>::end() {
+		// builders that only forward the events, as handler_builder, have no document to take
+		if constexpr (std::is_void_v<typename Builder::document_type>) {
+			report();
+		}
+		else {
+			auto document = _builder.take();
+			report();
+			return document;
+		}
+	}
+
+	template<class Builder>
+	Builder& basic_parser<Builder>::builder() noexcept {
+		return _builder;
+	}
+
+	template<class Builder>
+	bool basic_parser<Builder>::stopped() const noexcept {
+		return _stopped;
+	}
+
+	template<class Builder>
+	bool basic_parser<Builder>::recovered() const noexcept {
+		return _recovered;
+	}
+
+	template<class Builder>
+	const parse_options& basic_parser<Builder>::options() const {
+		return _options;
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::set_options(const parse_options& options) {
+		_options = options;
+		// builders that store values themselves take the options that shape them
+		if constexpr (requires { _builder.set_options(options); }) {
+			_builder.set_options(options);
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::set_instrumentation(const instrumentation* instrumentation) {
+		_instrumentation = instrumentation;
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::start() {
+		next_token();
+		if (!_stopped) {
+			statement();
+			// past a token that does not start a statement nothing more is built, in later parts either
+			_stopped = _curr_token.category != token_category::T_EOF or _depth > 0;
+		}
+
+		// lexes whatever the grammar did not reach, so lexical errors are still reported for the whole input
+		while (_curr_token.category != token_category::T_EOF) {
+			next_token();
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::statement() {
+		while (_curr_token.category == token_category::T_KEY) {
+			key();
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::key() {
+		build([&]() { _builder.on_key(_lexer.image(_curr_token)); });
+		next_token();
+		consume_token(token_category::T_DATA_SEP);
+		value();
+		consume_token(token_category::T_END_OF_DATA);
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::value() {
+		do {
+			// nested arrays are opened in place, so the call depth does not grow with the data
+			auto opened = false;
+			while (_curr_token.category == token_category::T_OPEN_ARRAY) {
+				tarray();
+				opened = true;
+			}
+
+			switch (_curr_token.category) {
+			case token_category::T_STRING:
+				tstring();
+				break;
+			case token_category::T_CHAR:
+				tchar();
+				break;
+			case token_category::T_INTEGER:
+				tinteger();
+				break;
+			case token_category::T_FLOAT:
+				tfloat();
+				break;
+			case token_category::T_BOOL:
+				tbool();
+				break;
+			case token_category::T_NULL:
+				tnull();
+				break;
+			case token_category::T_CLOSE_ARRAY:
+				// an array closed right after it opens is empty, it is closed by the array selector
+				if (opened) {
+					break;
+				}
+				error_message("a value or array");
+				break;
+			default:
+				error_message("a value or array");
+			}
+		} while (_depth > 0 and array_selector());
+	}
+
+	template<class Builder>
+	bool basic_parser<Builder>::array_selector() {
+		while (true) {
+			switch (_curr_token.category) {
+			case token_category::T_ARRAY_SEP:
+				next_token();
+				return true;
+			case token_category::T_CLOSE_ARRAY:
+				if (_depth == 0) {
+					error_message("';'");
+					return false;
+				}
+				close_array();
+				next_token();
+				break;
+			case token_category::T_END_OF_DATA:
+			case token_category::T_EOF:
+				return false;
+			default:
+				error_message("',', ']' or ';'");
+				return false;
+			}
+		}
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tarray() {
+		open_array();
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tstring() {
+		auto image = _lexer.image(_curr_token);
+		auto content = image.substr(1, image.length() - 2);
+		// only strings with escape chars need to be decoded into the buffer
+		if (content.find('\\') != std::string_view::npos) {
+			_string_buffer.clear();
+			decode_string(content, _string_buffer);
+			content = _string_buffer;
+		}
+		build([&]() { _builder.on_string(content); });
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tchar() {
+		auto image = _lexer.image(_curr_token);
+		char cValue = decode_char(image.substr(1, image.length() - 2));
+		build([&]() { _builder.on_char(cValue); });
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tinteger() {
+		// the d suffix is left out of the decoded chars
+		auto image = _lexer.image(_curr_token);
+		long long int intValue = 0;
+		auto result = std::from_chars(image.data(), image.data() + image.length(), intValue);
+		if (result.ec != std::errc()) {
+			invalid_constant(result.ec);
+		}
+		build([&]() { _builder.on_int(intValue); });
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tfloat() {
+		// the f or d suffix is left out of the decoded chars
+		auto image = _lexer.image(_curr_token);
+		auto first = image.data();
+		auto last = image.data() + image.length();
+		auto result = std::from_chars_result();
+
+		if (_options.floats == float_mode::F_LONG_DOUBLE) {
+			long double floatValue = 0;
+			result = std::from_chars(first, last, floatValue);
+			if (result.ec == std::errc()) {
+				build([&]() { _builder.on_long_double(floatValue); });
+			}
+		}
+		else if (_options.floats == float_mode::F_NATIVE and std::tolower((unsigned char)image.back()) == 'f') {
+			float floatValue = 0;
+			result = std::from_chars(first, last, floatValue);
+			if (result.ec == std::errc()) {
+				build([&]() { _builder.on_float(floatValue); });
+			}
+		}
+		else {
+			double floatValue = 0;
+			result = std::from_chars(first, last, floatValue);
+			if (result.ec == std::errc()) {
+				build([&]() { _builder.on_double(floatValue); });
+			}
+		}
+
+		if (result.ec != std::errc()) {
+			invalid_constant(result.ec);
+		}
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tbool() {
+		bool boolValue = _lexer.image(_curr_token) == "true";
+		build([&]() { _builder.on_bool(boolValue); });
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::tnull() {
+		build([&]() { _builder.on_null(); });
+		next_token();
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::open_array() {
+		++_depth;
+		if (_metrics != nullptr and _depth > _call.max_depth) {
+			_call.max_depth = _depth;
+		}
+		build([&]() { _builder.on_array_begin(); });
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::close_array() {
+		--_depth;
+		build([&]() { _builder.on_array_end(); });
+	}
+
+	template<class Builder>
+	template<class Event>
+	void basic_parser<Builder>::build(Event&& event) {
+		if (_metrics == nullptr) {
+			event();
+			return;
+		}
+		auto begin = std::chrono::steady_clock::now();
+		event();
+		_call.build_time += std::chrono::steady_clock::now() - begin;
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::next_token() {
+		if (_metrics == nullptr) {
+			_lexer.next_token(_curr_token);
+			return;
+		}
+		auto begin = std::chrono::steady_clock::now();
+		_lexer.next_token(_curr_token);
+		_call.lex_time += std::chrono::steady_clock::now() - begin;
+		++_call.tokens[_curr_token.category];
+	}
+
+	template<class Builder>
+	std::string basic_parser<Builder>::error_message(std::string expected) {
+		_recovered = true;
+		int line, collumn;
+		_lexer.location(_curr_token.offset, line, collumn);
+		return build_parser_error_message(std::string(_lexer.image(_curr_token)), line, collumn, expected);
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::invalid_constant(std::errc ec) {
+		int line, collumn;
+		_lexer.location(_curr_token.offset, line, collumn);
+		std::stringstream msg;
+		msg << (ec == std::errc::result_out_of_range ? "Out of range" : "Invalid");
+		msg << " numeric constant '";
+		msg << _lexer.image(_curr_token);
+		msg << "'";
+		if (ec == std::errc::result_out_of_range) {
+			throw std::out_of_range(build_lexer_error_message(msg.str(), line, collumn));
+		}
+		throw std::invalid_argument(build_lexer_error_message(msg.str(), line, collumn));
+	}
+
+	template<class Builder>
+	void basic_parser<Builder>::consume_token(token_category category) {
+		if (_curr_token.category != category) {
+			error_message(TOKEN_IMAGE[(int)category]);
+		}
+		next_token();
+	}
+
+	// writes a numeric literal, floats formatted like the default ostream formatting,
+	// with six significant digits
+	template<class T>
+	void write_number(T v, std::string& output) {
+		char chars[64];
+		std::to_chars_result result;
+		if constexpr (std::is_floating_point_v<T>) {
+			result = std::to_chars(chars, chars + sizeof(chars), v, std::chars_format::general, 6);
+		}
+		else {
+			result = std::to_chars(chars, chars + sizeof(chars), v);
+		}
+		output.append(chars, result.ptr);
+	}
+
+	// writes a string literal, escaping its double quotes
+	void write_string(std::string_view, std::string&);
+
+	// writes a char literal, escaping a quote
+	void write_char(char, std::string&);
+
+	// writes BPS files as plain text, the output buffer is kept between calls
 	class plain {
 	private:
-		static std::stringstream _plain_string_builder;
-		static void init();
+		std::string _buffer;
+		const instrumentation* _instrumentation = nullptr;
 
 	public:
-		static std::string parse(std::map<std::string, std::any>);
+		std::string parse(const std::map<std::string, std::any>&);
+		std::string parse(const std::map<std::string, value>&);
+		std::string parse(const flat_map<std::any>&);
+		std::string parse(const flat_map<value>&);
+
+		// appends the plain text to output, callers can reuse its memory between files
+		void write(const std::map<std::string, std::any>&, std::string&);
+		void write(const std::map<std::string, value>&, std::string&);
+		void write(const flat_map<std::any>&, std::string&);
+		void write(const flat_map<value>&, std::string&);
+
+		// appends the plain text of a single value
+		void write_value(const std::any&, std::string&);
+		void write_value(const value&, std::string&);
+
+		// reports the metrics of each document written, nullptr stops reporting
+		void set_instrumentation(const instrumentation*);
 
 	private:
-		static void parse_value(std::any);
-		static void parse_array(std::vector<std::any>);
+		template<class Document>
+		std::string parse_document(const Document&);
+		template<class Document>
+		void write_document(const Document&, std::string&);
+
+		void write_array(const std::vector<std::any>&, std::string&);
+		void write_array(const value::array_type&, std::string&);
+
+		// writes the items of one dimension straight from the typed buffer
+		void write_typed(const typed_array&, std::size_t, std::size_t&, std::string&);
 	};
 
+
 }
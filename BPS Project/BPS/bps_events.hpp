@@ -0,0 +1,157 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+
+
+namespace bps_core {
+
+	// takes the parser events of a document: on_key is required, and the other events, on_null, on_bool,
+	// on_char, on_int, on_float, on_double, on_long_double, on_string, on_array_begin and on_array_end,
+	// are skipped when not declared. Keys and strings are only valid during the call
+	template<class Handler>
+	concept handler = requires(Handler& h, std::string_view key) {
+		h.on_key(key);
+	};
+
+	// forwards the parser events to a handler owned by the caller, the calls are resolved at compile
+	// time so a handler that builds nothing costs only the parse. A float goes to the handler method
+	// of its type, or else to on_double, on_long_double or on_float, the first one declared
+	template<handler Handler>
+	class handler_builder {
+	private:
+		Handler* _handler = nullptr;
+
+		template<class T>
+		void on_real(T);
+
+	public:
+		using document_type = void;
+
+		void bind(Handler&) noexcept;
+
+		void reset();
+		void take();
+
+		void on_key(std::string_view);
+		void on_null();
+		void on_bool(bool);
+		void on_char(char);
+		void on_int(long long);
+		void on_float(float);
+		void on_double(double);
+		void on_long_double(long double);
+		void on_string(std::string_view);
+		void on_array_begin();
+		void on_array_end();
+	};
+
+	template<handler Handler>
+	using event_parser = basic_parser<handler_builder<Handler>>;
+
+	// the document builders are handlers as well
+	static_assert(handler<any_builder> and handler<value_builder>);
+
+	template<handler Handler>
+	void handler_builder<Handler>::bind(Handler& handler) noexcept {
+		_handler = &handler;
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::reset() {
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::take() {
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_key(std::string_view key) {
+		_handler->on_key(key);
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_null() {
+		if constexpr (requires { _handler->on_null(); }) {
+			_handler->on_null();
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_bool(bool v) {
+		if constexpr (requires { _handler->on_bool(v); }) {
+			_handler->on_bool(v);
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_char(char v) {
+		if constexpr (requires { _handler->on_char(v); }) {
+			_handler->on_char(v);
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_int(long long v) {
+		if constexpr (requires { _handler->on_int(v); }) {
+			_handler->on_int(v);
+		}
+	}
+
+	template<handler Handler>
+	template<class T>
+	void handler_builder<Handler>::on_real(T v) {
+		if constexpr (std::is_same_v<T, float> and requires { _handler->on_float(v); }) {
+			_handler->on_float(v);
+		}
+		else if constexpr (std::is_same_v<T, long double> and requires { _handler->on_long_double(v); }) {
+			_handler->on_long_double(v);
+		}
+		else if constexpr (requires { _handler->on_double(double(v)); }) {
+			_handler->on_double(double(v));
+		}
+		else if constexpr (requires { _handler->on_long_double((long double)v); }) {
+			_handler->on_long_double((long double)v);
+		}
+		else if constexpr (requires { _handler->on_float(float(v)); }) {
+			_handler->on_float(float(v));
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_float(float v) {
+		on_real(v);
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_double(double v) {
+		on_real(v);
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_long_double(long double v) {
+		on_real(v);
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_string(std::string_view v) {
+		if constexpr (requires { _handler->on_string(v); }) {
+			_handler->on_string(v);
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_array_begin() {
+		if constexpr (requires { _handler->on_array_begin(); }) {
+			_handler->on_array_begin();
+		}
+	}
+
+	template<handler Handler>
+	void handler_builder<Handler>::on_array_end() {
+		if constexpr (requires { _handler->on_array_end(); }) {
+			_handler->on_array_end();
+		}
+	}
+
+}
@@ -0,0 +1,425 @@
+#include "pch.h"
+#include "bps_extract.hpp"
+
+namespace bps_core {
+
+	// drops the skip chars around str
+	static std::string_view trim(std::string_view str) {
+		while (!str.empty() and (unsigned char)str.front() <= symbols::SPACE) {
+			str.remove_prefix(1);
+		}
+		while (!str.empty() and (unsigned char)str.back() <= symbols::SPACE) {
+			str.remove_suffix(1);
+		}
+		return str;
+	}
+
+	extractor::extractor() {
+		_rest_parser.builder().bind(_rest_handler);
+	}
+
+	void extractor::set_paths(std::span<const std::string_view> paths) {
+		_paths.clear();
+		_keys.clear();
+
+		for (auto text : paths) {
+			auto p = path();
+			p.text = text;
+			auto bracket = text.find(symbols::LEFT_BRACKETS);
+			p.key = text.substr(0, bracket);
+
+			// the key must read back as a single key token, followed only by [index] parts
+			auto tok = token_view();
+			_lexer.load(p.key);
+			_lexer.next_token(tok);
+			auto valid = tok.category == token_category::T_KEY and tok.length == p.key.length();
+			while (valid and bracket != std::string_view::npos) {
+				auto close = text.find(symbols::RIGHT_BRACKETS, bracket);
+				auto index = std::size_t(0);
+				auto result = std::from_chars(text.data() + bracket + 1, text.data() + std::min(close, text.length()), index);
+				valid = close != std::string_view::npos and result.ec == std::errc() and result.ptr == text.data() + close;
+				p.indices.push_back(index);
+				bracket = close + 1 < text.length() ? close + 1 : std::string_view::npos;
+				valid = valid and (bracket == std::string_view::npos or text[bracket] == symbols::LEFT_BRACKETS);
+			}
+			if (!valid) {
+				std::stringstream msg;
+				msg << "Invalid path '";
+				msg << text;
+				msg << "'.";
+				throw std::invalid_argument(msg.str());
+			}
+
+			auto key_index = _keys.size();
+			_keys.try_emplace(p.key, std::move(key_index));
+			_paths.push_back(std::move(p));
+		}
+	}
+
+	std::map<std::string, std::any> extractor::extract(std::string_view data) {
+		auto extracted = std::map<std::string, std::any>();
+		_found.assign(_keys.size(), false);
+		auto remaining = _keys.size();
+
+		auto tok = token_view();
+		_lexer.load(data);
+		_lexer.next_token(tok);
+		while (remaining > 0 and tok.category == token_category::T_KEY) {
+			auto begin = tok.offset;
+			auto key = _lexer.image(tok);
+			_lexer.next_token(tok);
+			auto value_end = tok.category == token_category::T_DATA_SEP ? skip_value(data, tok.offset + tok.length) : std::string_view::npos;
+			if (value_end == std::string_view::npos) {
+				recover(data, begin, extracted);
+				break;
+			}
+			auto value_begin = tok.offset + tok.length;
+			auto end = std::min(value_end + 1, data.length());
+
+			auto found = _keys.find(key);
+			if (found != nullptr and !_found[*found]) {
+				auto clean = true;
+				for (auto& p : _paths) {
+					if (p.key == key and !read(data, p, begin, value_begin, end, extracted)) {
+						clean = false;
+						break;
+					}
+				}
+				if (!clean) {
+					// the paths of the key are read again as the parser recovers from the statement
+					for (auto& p : _paths) {
+						if (p.key == key) {
+							extracted.erase(p.text);
+						}
+					}
+					recover(data, begin, extracted);
+					break;
+				}
+				_found[*found] = true;
+				--remaining;
+			}
+
+			// the lexer goes on from the next statement, the value was not lexed
+			_lexer.seek(end);
+			_lexer.next_token(tok);
+		}
+		return extracted;
+	}
+
+	std::size_t extractor::skip_value(std::string_view data, std::size_t begin) {
+		// only the brackets are followed, a ',' or ':' out of arrays or a ';' in one is malformed
+		auto rest = data.substr(begin);
+		auto depth = 0;
+		auto malformed = false;
+		_scanner.reset();
+		auto end = _scanner.walk(rest, [&](std::size_t, char c) {
+			switch (c) {
+			case symbols::LEFT_BRACKETS:
+				++depth;
+				return true;
+			case symbols::RIGHT_BRACKETS:
+				malformed = --depth < 0;
+				return !malformed;
+			case symbols::COMMA:
+				malformed = depth == 0;
+				return !malformed;
+			case symbols::SEMICOLON:
+				malformed = depth > 0;
+				return false;
+			default:
+				malformed = true;
+				return false;
+			}
+		});
+		// as in the parser, the end of the input ends the last statement
+		if (malformed or depth > 0) {
+			return std::string_view::npos;
+		}
+		return begin + end;
+	}
+
+	bool extractor::find_item(std::string_view& value, std::size_t index, bool& malformed) {
+		auto arr = trim(value);
+		if (arr.empty() or arr.front() != symbols::LEFT_BRACKETS) {
+			return false;
+		}
+
+		auto depth = 0;
+		auto count = std::size_t(0);
+		auto item_begin = std::size_t(1);
+		auto found = false;
+		_scanner.reset();
+		_scanner.walk(arr, [&](std::size_t i, char c) {
+			switch (c) {
+			case symbols::LEFT_BRACKETS:
+				++depth;
+				return true;
+			case symbols::RIGHT_BRACKETS:
+				if (--depth > 0) {
+					return true;
+				}
+				break;
+			case symbols::COMMA:
+				if (depth > 1) {
+					return true;
+				}
+				break;
+			default:
+				return true;
+			}
+
+			// an item of the array ends at its ',' or at the ']' closing the array, only an empty array
+			// has an empty item
+			auto item = trim(arr.substr(item_begin, i - item_begin));
+			if (item.empty() and (c == symbols::COMMA or count > 0)) {
+				malformed = true;
+				return false;
+			}
+			if (count == index) {
+				value = item;
+				found = !value.empty();
+				return false;
+			}
+			++count;
+			item_begin = i + 1;
+			return depth > 0;
+		});
+		return found;
+	}
+
+	bool extractor::read(std::string_view data, const path& p, std::size_t begin, std::size_t value_begin, std::size_t end, std::map<std::string, std::any>& extracted) {
+		int line, collumn;
+		_parser.begin();
+		if (p.indices.empty()) {
+			_lexer.location(begin, line, collumn);
+			_parser.parse_part(data.substr(begin, end - begin), line, collumn);
+		}
+		else {
+			// the ';' is left out, so the last item is not read past
+			auto item = data.substr(value_begin, end - value_begin);
+			if (!item.empty() and item.back() == symbols::SEMICOLON) {
+				item.remove_suffix(1);
+			}
+			for (auto index : p.indices) {
+				auto malformed = false;
+				if (!find_item(item, index, malformed)) {
+					_parser.end();
+					return !malformed;
+				}
+			}
+
+			// the item is parsed as the value of a statement of its own, placed so its chars keep their location
+			_lexer.location((std::size_t)(item.data() - data.data()), line, collumn);
+			_statement = p.key;
+			_statement += symbols::COLON;
+			_statement += item;
+			_statement += symbols::SEMICOLON;
+			_parser.parse_part(_statement, line, collumn - (int)(p.key.length() + 1));
+		}
+
+		auto malformed = _parser.stopped() or _parser.recovered();
+		auto document = _parser.end();
+		if (malformed) {
+			return false;
+		}
+		auto found = document.find(p.key);
+		if (found != document.end()) {
+			extracted.try_emplace(p.text, std::move(found->second));
+		}
+		return true;
+	}
+
+	void extractor::recover(std::string_view data, std::size_t begin, std::map<std::string, std::any>& extracted) {
+		int line, collumn;
+		_lexer.location(begin, line, collumn);
+		auto found = _found;
+
+		_rest_handler.reset(extracted);
+		_rest_parser.begin();
+		_rest_parser.parse_part(data.substr(begin), line, collumn);
+		_rest_parser.end();
+
+		// the items were kept by the handler, the whole values are the ones of the document
+		auto document = _rest_handler.take();
+		for (auto& p : _paths) {
+			auto value = document.find(p.key);
+			if (p.indices.empty() and !found[*_keys.find(p.key)] and value != document.end()) {
+				extracted.try_emplace(p.text, value->second);
+			}
+		}
+	}
+
+	extractor::rest_handler::rest_handler(extractor& owner)
+		: _owner(owner) {
+	}
+
+	void extractor::rest_handler::reset(std::map<std::string, std::any>& extracted) {
+		_extracted = &extracted;
+		_key.clear();
+		_items.clear();
+		_document.reset();
+
+		// one capture for each distinct indices of the paths
+		_captures.clear();
+		for (auto& p : _owner._paths) {
+			auto same = [&p](const capture& c) { return c.indices == p.indices; };
+			if (!p.indices.empty() and std::none_of(_captures.begin(), _captures.end(), same)) {
+				auto& c = _captures.emplace_back();
+				c.indices = p.indices;
+				c.builder.set_options(_owner.options());
+			}
+		}
+	}
+
+	std::map<std::string, std::any> extractor::rest_handler::take() {
+		return _document.take();
+	}
+
+	void extractor::rest_handler::set_options(const parse_options& options) {
+		_document.set_options(options);
+		for (auto& c : _captures) {
+			c.builder.set_options(options);
+		}
+	}
+
+	template<class Event>
+	void extractor::rest_handler::forward(Event&& event) {
+		event(_document);
+		for (auto& c : _captures) {
+			if (c.active) {
+				event(c.builder);
+			}
+		}
+	}
+
+	void extractor::rest_handler::begin_item() {
+		if (_items.empty()) {
+			for (auto& c : _captures) {
+				c.found = false;
+			}
+		}
+		// the indices of the item are the indices of the next item of each open array
+		for (auto& c : _captures) {
+			if (!c.active and c.indices == _items) {
+				c.builder.reset();
+				c.builder.on_key(_key);
+				c.active = true;
+				c.depth = _items.size();
+			}
+		}
+	}
+
+	void extractor::rest_handler::end_item() {
+		for (auto& c : _captures) {
+			if (c.active and c.depth == _items.size()) {
+				auto item = c.builder.take();
+				c.active = false;
+				c.found = !item.empty();
+				if (c.found) {
+					c.value = std::move(item.begin()->second);
+				}
+			}
+		}
+		if (_items.empty()) {
+			end_value();
+		}
+		else {
+			++_items.back();
+		}
+	}
+
+	void extractor::rest_handler::end_value() {
+		// as in the builder, the value goes to the last key, and only the first value of a key is kept
+		auto found = _owner._keys.find(_key);
+		if (found == nullptr or _owner._found[*found]) {
+			return;
+		}
+		_owner._found[*found] = true;
+		for (auto& p : _owner._paths) {
+			if (p.key != _key or p.indices.empty()) {
+				continue;
+			}
+			for (auto& c : _captures) {
+				if (c.indices == p.indices and c.found) {
+					_extracted->try_emplace(p.text, c.value);
+				}
+			}
+		}
+	}
+
+	void extractor::rest_handler::on_key(std::string_view key) {
+		_key = key;
+		_document.on_key(key);
+	}
+
+	void extractor::rest_handler::on_null() {
+		begin_item();
+		forward([](any_builder& b) { b.on_null(); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_bool(bool v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_bool(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_char(char v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_char(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_int(long long v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_int(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_float(float v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_float(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_double(double v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_double(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_long_double(long double v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_long_double(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_string(std::string_view v) {
+		begin_item();
+		forward([v](any_builder& b) { b.on_string(v); });
+		end_item();
+	}
+
+	void extractor::rest_handler::on_array_begin() {
+		begin_item();
+		forward([](any_builder& b) { b.on_array_begin(); });
+		_items.push_back(0);
+	}
+
+	void extractor::rest_handler::on_array_end() {
+		forward([](any_builder& b) { b.on_array_end(); });
+		_items.pop_back();
+		end_item();
+	}
+
+	const parse_options& extractor::options() const {
+		return _parser.options();
+	}
+
+	void extractor::set_options(const parse_options& options) {
+		_parser.set_options(options);
+		_rest_parser.set_options(options);
+		_rest_handler.set_options(options);
+	}
+
+}
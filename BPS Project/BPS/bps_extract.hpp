@@ -0,0 +1,119 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_events.hpp"
+#include "bps_stream.hpp"
+
+
+namespace bps_core {
+
+	// reads only the values of some paths from an input, a path being a key or a key followed by array
+	// indices, as "key12[1][0]". Keys and ':' are lexed, the values of other keys are skipped to their
+	// ';' by the statement scanner, only following their brackets, and the items of a path are found the
+	// same way, so only the values asked for are parsed. The scan stops once every key was found, since
+	// the first value of a key is the one a parse keeps. From the first statement found malformed on, the
+	// input is parsed as a parse would recover from it. Errors in the values skipped are not reported
+	class extractor {
+	private:
+		struct path {
+			std::string text;
+			std::string key;
+			std::vector<std::size_t> indices;
+		};
+
+		// takes the parser events from a malformed statement on, keeping the values of the paths
+		class rest_handler {
+		private:
+			// an item of the value being built whose path matches indices, built on its own
+			struct capture {
+				std::vector<std::size_t> indices;
+				any_builder builder;
+				std::any value;
+				bool active = false;
+				bool found = false;
+				std::size_t depth = 0;
+			};
+
+			extractor& _owner;
+			std::map<std::string, std::any>* _extracted = nullptr;
+			std::vector<capture> _captures;
+			// the whole values, as a parse builds them
+			any_builder _document;
+
+			std::string _key;
+			// index of the next item of each open array
+			std::vector<std::size_t> _items;
+
+			// starts the captures of an item about to be built, the value being built when out of arrays
+			void begin_item();
+			// ends the captures of items ended at the current depth, and the value when out of arrays
+			void end_item();
+			void end_value();
+
+			template<class Event>
+			void forward(Event&&);
+
+		public:
+			explicit rest_handler(extractor&);
+
+			void reset(std::map<std::string, std::any>&);
+			// values of the keys found since reset, by key
+			std::map<std::string, std::any> take();
+			void set_options(const parse_options&);
+
+			void on_key(std::string_view);
+			void on_null();
+			void on_bool(bool);
+			void on_char(char);
+			void on_int(long long);
+			void on_float(float);
+			void on_double(double);
+			void on_long_double(long double);
+			void on_string(std::string_view);
+			void on_array_begin();
+			void on_array_end();
+		};
+
+		std::vector<path> _paths;
+		// index of each distinct key of the paths
+		flat_map<std::size_t> _keys;
+		std::vector<bool> _found;
+
+		lexer _lexer;
+		statement_scanner _scanner;
+		parser _parser;
+		// statement of an array item, parsed on its own
+		std::string _statement;
+
+		rest_handler _rest_handler{ *this };
+		event_parser<rest_handler> _rest_parser;
+
+		// index of the ';' that ends the value starting at begin, or the input length when the input ends
+		// it, npos if its brackets do not match
+		std::size_t skip_value(std::string_view, std::size_t);
+		// narrows value to the item at index, false if value is not an array or has no such item, or
+		// if an empty item is found before it, which is malformed
+		bool find_item(std::string_view&, std::size_t, bool&);
+		// parses the value of a path from the statement at begin, whose value starts at value_begin,
+		// false if the statement is malformed
+		bool read(std::string_view, const path&, std::size_t, std::size_t, std::size_t, std::map<std::string, std::any>&);
+		// parses the input from the malformed statement at begin on, as a parse would recover from it
+		void recover(std::string_view, std::size_t, std::map<std::string, std::any>&);
+
+	public:
+		extractor();
+		// the handler refers to its extractor
+		extractor(const extractor&) = delete;
+		extractor& operator=(const extractor&) = delete;
+
+		void set_paths(std::span<const std::string_view>);
+
+		// values of the paths found in the input, by path
+		std::map<std::string, std::any> extract(std::string_view);
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+	};
+
+}
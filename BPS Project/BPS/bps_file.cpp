@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "bps_file.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bps_core {
+
+	mapped_file::mapped_file(const std::filesystem::path& path) {
+#ifdef _WIN32
+		// sequential scan makes the cache manager read ahead of the parser
+		auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			error("Could not open file", path, (int)GetLastError());
+		}
+		_file = file;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			auto code = (int)GetLastError();
+			close();
+			error("Could not read the size of file", path, code);
+		}
+		_size = (std::size_t)size.QuadPart;
+
+		// empty files can not be mapped, they are read as an empty view
+		if (_size == 0) {
+			return;
+		}
+
+		_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping == nullptr) {
+			auto code = (int)GetLastError();
+			close();
+			error("Could not map file", path, code);
+		}
+		_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (_data == nullptr) {
+			auto code = (int)GetLastError();
+			close();
+			error("Could not map file", path, code);
+		}
+#else
+		auto file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0) {
+			error("Could not open file", path, errno);
+		}
+
+		struct stat info;
+		if (fstat(file, &info) != 0) {
+			auto code = errno;
+			::close(file);
+			error("Could not read the size of file", path, code);
+		}
+		_size = (std::size_t)info.st_size;
+
+		// empty files can not be mapped, they are read as an empty view
+		if (_size == 0) {
+			::close(file);
+			return;
+		}
+
+		auto data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+		auto code = errno;
+		// the mapping keeps the file referenced by itself
+		::close(file);
+		if (data == MAP_FAILED) {
+			_size = 0;
+			error("Could not map file", path, code);
+		}
+
+		// the parser reads the file once from start to end
+		madvise(data, _size, MADV_SEQUENTIAL);
+		madvise(data, _size, MADV_WILLNEED);
+		_data = static_cast<const char*>(data);
+#endif
+	}
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept {
+		swap(other);
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+		if (this != &other) {
+			close();
+			swap(other);
+		}
+		return *this;
+	}
+
+	mapped_file::~mapped_file() {
+		close();
+	}
+
+	std::string_view mapped_file::view() const noexcept {
+		return std::string_view(_data, _data == nullptr ? 0 : _size);
+	}
+
+	std::size_t mapped_file::size() const noexcept {
+		return _size;
+	}
+
+	bool mapped_file::is_open() const noexcept {
+		return _data != nullptr;
+	}
+
+	bool mapped_file::contains(std::string_view str) const noexcept {
+		if (_data == nullptr or str.data() == nullptr) {
+			return false;
+		}
+		auto begin = reinterpret_cast<std::uintptr_t>(_data);
+		auto first = reinterpret_cast<std::uintptr_t>(str.data());
+		return first >= begin and first + str.length() <= begin + _size;
+	}
+
+	void mapped_file::close() noexcept {
+#ifdef _WIN32
+		if (_data != nullptr) {
+			UnmapViewOfFile(_data);
+		}
+		if (_mapping != nullptr) {
+			CloseHandle(_mapping);
+		}
+		if (_file != nullptr) {
+			CloseHandle(_file);
+		}
+		_mapping = nullptr;
+		_file = nullptr;
+#else
+		if (_data != nullptr) {
+			munmap(const_cast<char*>(_data), _size);
+		}
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	void mapped_file::swap(mapped_file& other) noexcept {
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+#ifdef _WIN32
+		std::swap(_file, other._file);
+		std::swap(_mapping, other._mapping);
+#endif
+	}
+
+	void mapped_file::error(std::string problem, const std::filesystem::path& path, int code) {
+		std::stringstream msg;
+		msg << problem;
+		msg << " '";
+		msg << path.string();
+		msg << "'";
+#ifdef _WIN32
+		throw std::system_error(code, std::system_category(), msg.str());
+#else
+		throw std::system_error(code, std::generic_category(), msg.str());
+#endif
+	}
+
+}
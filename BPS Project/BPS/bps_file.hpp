@@ -0,0 +1,41 @@
+#pragma once
+
+#include "pch.h"
+
+
+namespace bps_core {
+
+	// read only memory mapping of a whole file, the pages are read by the system as they are touched
+	class mapped_file {
+	private:
+		const char* _data = nullptr;
+		std::size_t _size = 0;
+#ifdef _WIN32
+		void* _file = nullptr;
+		void* _mapping = nullptr;
+#endif
+
+	public:
+		mapped_file() = default;
+		explicit mapped_file(const std::filesystem::path&);
+		mapped_file(const mapped_file&) = delete;
+		mapped_file(mapped_file&&) noexcept;
+		mapped_file& operator=(const mapped_file&) = delete;
+		mapped_file& operator=(mapped_file&&) noexcept;
+		~mapped_file();
+
+		std::string_view view() const noexcept;
+		std::size_t size() const noexcept;
+		bool is_open() const noexcept;
+
+		// whether str lies inside the mapped pages
+		bool contains(std::string_view) const noexcept;
+
+		void close() noexcept;
+
+	private:
+		void swap(mapped_file&) noexcept;
+		[[noreturn]] static void error(std::string, const std::filesystem::path&, int);
+	};
+
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_value.hpp"
+
+
+namespace bps_core {
+
+	// order a flat_map iterates its keys in
+	enum key_order : std::uint8_t {
+		// sorted by key, as a std::map would iterate them
+		K_SORTED = 0,
+		// in the order they were inserted, as they appear in the parsed data
+		K_INSERTION = 1
+	};
+
+	// document whose entries lie in one contiguous vector, found through an open addressing table of
+	// their precomputed hashes. Keys are looked up as std::string_view, without building a std::string.
+	// The entries are only iterated as const, since a key changed in place would no longer be found by
+	// its hash, values are changed through find or at
+	template<class Value>
+	class flat_map {
+	public:
+		using value_type = std::pair<std::string, Value>;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+		using iterator = const_iterator;
+
+	private:
+		std::vector<value_type> _entries;
+		// hash of the key of each entry
+		std::vector<std::size_t> _hashes;
+		// entry index + 1 of each slot, 0 for empty slots, its size is 0 or a power of two
+		std::vector<std::uint32_t> _slots;
+
+		static std::size_t hash(std::string_view) noexcept;
+
+		// slot holding key, or the empty slot it would be inserted in
+		std::size_t slot(std::string_view, std::size_t) const noexcept;
+		void rehash(std::size_t);
+		// points an empty table at every entry
+		void fill_slots() noexcept;
+
+	public:
+		flat_map() = default;
+
+		const_iterator begin() const noexcept;
+		const_iterator end() const noexcept;
+
+		std::size_t size() const noexcept;
+		bool empty() const noexcept;
+
+		bool contains(std::string_view) const;
+		Value* find(std::string_view);
+		const Value* find(std::string_view) const;
+		Value& at(std::string_view);
+		const Value& at(std::string_view) const;
+
+		// inserts the value if key is missing, the value of a key already there is kept, as in a std::map
+		bool try_emplace(std::string_view, Value&&);
+
+		void reserve(std::size_t);
+		void clear() noexcept;
+
+		// orders the entries by key, iteration then follows the key order of a std::map
+		void sort();
+	};
+
+	template<class Value>
+	std::size_t flat_map<Value>::hash(std::string_view key) noexcept {
+		return std::hash<std::string_view>()(key);
+	}
+
+	template<class Value>
+	std::size_t flat_map<Value>::slot(std::string_view key, std::size_t key_hash) const noexcept {
+		// linear probing, the table is kept at most half full so the probe sequences stay short
+		auto mask = _slots.size() - 1;
+		for (auto i = key_hash & mask; ; i = (i + 1) & mask) {
+			auto index = _slots[i];
+			if (index == 0) {
+				return i;
+			}
+			if (_hashes[index - 1] == key_hash and _entries[index - 1].first == key) {
+				return i;
+			}
+		}
+	}
+
+	template<class Value>
+	void flat_map<Value>::rehash(std::size_t capacity) {
+		auto slots = std::size_t(16);
+		while (slots < capacity * 2) {
+			slots *= 2;
+		}
+		if (slots <= _slots.size()) {
+			return;
+		}
+
+		_slots.assign(slots, 0);
+		fill_slots();
+	}
+
+	template<class Value>
+	void flat_map<Value>::fill_slots() noexcept {
+		auto mask = _slots.size() - 1;
+		for (auto e = std::size_t(0); e < _entries.size(); ++e) {
+			auto i = _hashes[e] & mask;
+			while (_slots[i] != 0) {
+				i = (i + 1) & mask;
+			}
+			_slots[i] = (std::uint32_t)(e + 1);
+		}
+	}
+
+	template<class Value>
+	typename flat_map<Value>::const_iterator flat_map<Value>::begin() const noexcept {
+		return _entries.begin();
+	}
+
+	template<class Value>
+	typename flat_map<Value>::const_iterator flat_map<Value>::end() const noexcept {
+		return _entries.end();
+	}
+
+	template<class Value>
+	std::size_t flat_map<Value>::size() const noexcept {
+		return _entries.size();
+	}
+
+	template<class Value>
+	bool flat_map<Value>::empty() const noexcept {
+		return _entries.empty();
+	}
+
+	template<class Value>
+	bool flat_map<Value>::contains(std::string_view key) const {
+		return find(key) != nullptr;
+	}
+
+	template<class Value>
+	Value* flat_map<Value>::find(std::string_view key) {
+		return const_cast<Value*>(std::as_const(*this).find(key));
+	}
+
+	template<class Value>
+	const Value* flat_map<Value>::find(std::string_view key) const {
+		if (_entries.empty()) {
+			return nullptr;
+		}
+		auto index = _slots[slot(key, hash(key))];
+		if (index == 0) {
+			return nullptr;
+		}
+		return &_entries[index - 1].second;
+	}
+
+	template<class Value>
+	Value& flat_map<Value>::at(std::string_view key) {
+		return const_cast<Value&>(std::as_const(*this).at(key));
+	}
+
+	template<class Value>
+	const Value& flat_map<Value>::at(std::string_view key) const {
+		auto found = find(key);
+		if (found == nullptr) {
+			std::stringstream msg;
+			msg << "Key '";
+			msg << key;
+			msg << "' not found.";
+			throw std::out_of_range(msg.str());
+		}
+		return *found;
+	}
+
+	template<class Value>
+	bool flat_map<Value>::try_emplace(std::string_view key, Value&& v) {
+		if (_entries.size() >= std::numeric_limits<std::uint32_t>::max()) {
+			throw std::length_error("flat_map is limited to 2^32 - 1 keys.");
+		}
+		rehash(_entries.size() + 1);
+
+		auto key_hash = hash(key);
+		auto i = slot(key, key_hash);
+		if (_slots[i] != 0) {
+			return false;
+		}
+		_entries.emplace_back(std::string(key), std::move(v));
+		_hashes.push_back(key_hash);
+		_slots[i] = (std::uint32_t)_entries.size();
+		return true;
+	}
+
+	template<class Value>
+	void flat_map<Value>::reserve(std::size_t capacity) {
+		_entries.reserve(capacity);
+		_hashes.reserve(capacity);
+		rehash(capacity);
+	}
+
+	template<class Value>
+	void flat_map<Value>::clear() noexcept {
+		_entries.clear();
+		_hashes.clear();
+		std::fill(_slots.begin(), _slots.end(), 0);
+	}
+
+	template<class Value>
+	void flat_map<Value>::sort() {
+		auto order = std::vector<std::uint32_t>(_entries.size());
+		for (auto e = std::size_t(0); e < order.size(); ++e) {
+			order[e] = (std::uint32_t)e;
+		}
+		std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+			return _entries[a].first < _entries[b].first;
+		});
+
+		auto entries = std::vector<value_type>();
+		auto hashes = std::vector<std::size_t>();
+		entries.reserve(_entries.size());
+		hashes.reserve(_hashes.size());
+		for (auto e : order) {
+			entries.push_back(std::move(_entries[e]));
+			hashes.push_back(_hashes[e]);
+		}
+		_entries = std::move(entries);
+		_hashes = std::move(hashes);
+
+		// the slots point to entry indexes, which just changed
+		std::fill(_slots.begin(), _slots.end(), 0);
+		fill_slots();
+	}
+
+}
@@ -0,0 +1,295 @@
+#include "pch.h"
+#include "bps_lazy.hpp"
+
+namespace bps_core {
+
+	void lazy_document::load(std::string_view input) {
+		_file.close();
+		_input = input;
+		index();
+	}
+
+	void lazy_document::load(mapped_file&& file) {
+		_file = std::move(file);
+		_input = _file.view();
+		index();
+	}
+
+	void lazy_document::index() {
+		_entries.clear();
+		_duplicates.clear();
+		_rest.clear();
+
+		// only the keys and ':' are lexed, the values are skipped to their ';'
+		try {
+			auto tok = token_view();
+			auto recovered = false;
+			_lexer.load(_input);
+			_lexer.next_token(tok);
+			while (tok.category == token_category::T_KEY) {
+				auto start = tok.offset;
+				int line, collumn;
+				_lexer.location(start, line, collumn);
+				auto key = _lexer.image(tok);
+
+				_lexer.next_token(tok);
+				auto end = tok.category == token_category::T_DATA_SEP ? skip_value(tok.offset + tok.length) : npos;
+				if (end == npos) {
+					// a malformed statement is parsed right away with the rest of the input, so it recovers
+					// or stops exactly as the parser does
+					parse_rest(start, line, collumn);
+					recovered = true;
+					break;
+				}
+
+				auto& e = _entries.emplace_back();
+				e.key = key;
+				e.statement = _input.substr(start, end - start);
+				e.line = line;
+				e.collumn = collumn;
+				e.decoded = false;
+
+				_lexer.seek(end);
+				_lexer.next_token(tok);
+			}
+
+			// as in the parser, nothing is built past a token that does not start a statement,
+			// the rest is only lexed so lexical errors are still reported
+			while (!recovered and tok.category != token_category::T_EOF) {
+				_lexer.next_token(tok);
+			}
+		}
+		catch (...) {
+			// the values skipped may hold errors before this one, the whole input is parsed so the
+			// error thrown is the first one, as in a parse
+			_entries.clear();
+			_rest.clear();
+			_parser.parse(_input);
+			throw;
+		}
+
+		sort_entries();
+	}
+
+	std::size_t lazy_document::skip_value(std::size_t begin) {
+		// only the brackets are followed, a ',' or ':' out of arrays or a ';' in one is malformed
+		auto rest = _input.substr(begin);
+		auto depth = 0;
+		auto ended = false;
+		_scanner.reset();
+		auto end = _scanner.walk(rest, [&](std::size_t, char c) {
+			switch (c) {
+			case symbols::LEFT_BRACKETS:
+				++depth;
+				return true;
+			case symbols::RIGHT_BRACKETS:
+				return --depth >= 0;
+			case symbols::COMMA:
+				return depth > 0;
+			case symbols::SEMICOLON:
+				ended = depth == 0;
+				return false;
+			default:
+				return false;
+			}
+		});
+		return ended ? begin + end + 1 : npos;
+	}
+
+	void lazy_document::parse_rest(std::size_t start, int line, int collumn) {
+		_parser.begin();
+		_parser.parse_part(_input.substr(start), line, collumn);
+		_rest = _parser.end();
+
+		// the keys point into the parsed map, whose nodes are never moved, and the empty statement
+		// keeps where the rest starts
+		for (auto& r : _rest) {
+			auto& e = _entries.emplace_back();
+			e.key = r.first;
+			e.statement = _input.substr(start, 0);
+			e.line = line;
+			e.collumn = collumn;
+			e.decoded = true;
+			e.cached = std::move(r.second);
+		}
+	}
+
+	void lazy_document::sort_entries() {
+		// stable, so the first statement of a key stays first
+		std::stable_sort(_entries.begin(), _entries.end(), [](const entry& a, const entry& b) {
+			return a.key < b.key;
+		});
+		auto kept = std::size_t(0);
+		for (auto& e : _entries) {
+			if (kept > 0 and _entries[kept - 1].key == e.key) {
+				// values of the rest were parsed with it already
+				if (!e.decoded) {
+					_duplicates.push_back(std::move(e));
+				}
+				continue;
+			}
+			if (&_entries[kept] != &e) {
+				_entries[kept] = std::move(e);
+			}
+			++kept;
+		}
+		_entries.resize(kept);
+		_decoded = (std::size_t)std::count_if(_entries.begin(), _entries.end(), [](const entry& e) {
+			return e.decoded;
+		});
+	}
+
+	bool lazy_document::parse_statement(const entry& e, value* v) {
+		_parser.begin();
+		_parser.parse_part(e.statement, e.line, e.collumn);
+		auto malformed = _parser.stopped() or _parser.recovered();
+		auto parsed = _parser.end();
+
+		if (malformed) {
+			// the recovery depends on the input after the statement, which is parsed with it
+			auto start = (std::size_t)(e.statement.data() - _input.data());
+			auto line = e.line;
+			auto collumn = e.collumn;
+			auto after = [start, this](const entry& other) {
+				return (std::size_t)(other.statement.data() - _input.data()) >= start;
+			};
+			std::erase_if(_entries, after);
+			std::erase_if(_duplicates, after);
+			parse_rest(start, line, collumn);
+			sort_entries();
+			return false;
+		}
+
+		if (v != nullptr) {
+			auto found = parsed.find(std::string(e.key));
+			if (found != parsed.end()) {
+				*v = std::move(found->second);
+			}
+		}
+		return true;
+	}
+
+	bool lazy_document::decode(std::size_t index) {
+		auto& e = _entries[index];
+		if (!parse_statement(e, &e.cached)) {
+			return false;
+		}
+		e.decoded = true;
+		++_decoded;
+		return true;
+	}
+	std::size_t lazy_document::position(std::string_view key) const {
+		auto it = std::lower_bound(_entries.begin(), _entries.end(), key, [](const entry& e, std::string_view k) {
+			return e.key < k;
+		});
+		if (it == _entries.end() or it->key != key) {
+			return npos;
+		}
+		return (std::size_t)(it - _entries.begin());
+	}
+
+	std::vector<std::string_view> lazy_document::keys() const {
+		auto keys = std::vector<std::string_view>();
+		keys.reserve(_entries.size());
+		for (auto& e : _entries) {
+			keys.push_back(e.key);
+		}
+		return keys;
+	}
+
+	std::size_t lazy_document::size() const noexcept {
+		return _entries.size();
+	}
+
+	bool lazy_document::contains(std::string_view key) const {
+		return position(key) != npos;
+	}
+
+	const value* lazy_document::find(std::string_view key) {
+		auto found = position(key);
+		// a malformed value replaces the entries from it on, the key is looked for again
+		while (found != npos and !_entries[found].decoded and !decode(found)) {
+			found = position(key);
+		}
+		if (found == npos) {
+			return nullptr;
+		}
+		return &_entries[found].cached;
+	}
+
+	const value& lazy_document::at(std::string_view key) {
+		auto found = find(key);
+		if (found == nullptr) {
+			std::stringstream msg;
+			msg << "Key '";
+			msg << key;
+			msg << "' not found.";
+			throw std::out_of_range(msg.str());
+		}
+		return *found;
+	}
+
+	std::map<std::string, value> lazy_document::to_map() {
+		// the statements not parsed yet, by where they start, a malformed one replaces the entries and
+		// duplicates after it so they are gathered again
+		struct pending {
+			const char* start;
+			std::size_t index;
+			bool duplicate;
+		};
+		auto statements = std::vector<pending>();
+		auto done = false;
+		while (!done) {
+			statements.clear();
+			for (auto i = std::size_t(0); i < _entries.size(); ++i) {
+				if (!_entries[i].decoded) {
+					statements.push_back({ _entries[i].statement.data(), i, false });
+				}
+			}
+			for (auto i = std::size_t(0); i < _duplicates.size(); ++i) {
+				if (!_duplicates[i].decoded) {
+					statements.push_back({ _duplicates[i].statement.data(), i, true });
+				}
+			}
+			std::sort(statements.begin(), statements.end(), [](const pending& a, const pending& b) {
+				return a.start < b.start;
+			});
+
+			done = true;
+			for (auto& p : statements) {
+				if (p.duplicate) {
+					// only parsed for its errors, the first value of the key is kept
+					done = parse_statement(_duplicates[p.index], nullptr);
+					if (done) {
+						_duplicates[p.index].decoded = true;
+					}
+				}
+				else {
+					done = decode(p.index);
+				}
+				if (!done) {
+					break;
+				}
+			}
+		}
+
+		auto data = std::map<std::string, value>();
+		for (auto& e : _entries) {
+			data.emplace_hint(data.end(), std::string(e.key), e.cached);
+		}
+		return data;
+	}
+
+	std::size_t lazy_document::decoded() const noexcept {
+		return _decoded;
+	}
+
+	const parse_options& lazy_document::options() const {
+		return _parser.options();
+	}
+
+	void lazy_document::set_options(const parse_options& options) {
+		_parser.set_options(options);
+	}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_file.hpp"
+#include "bps_stream.hpp"
+
+
+namespace bps_core {
+
+	// document that only indexes its keys when loaded, each value is parsed the first time it is read
+	// and then kept, reading values is not thread safe. Values are skipped at load by scanning to their
+	// ';', so their errors are found when they are read: a malformed value makes the rest of the input
+	// be parsed again from its statement on, as the parser would have recovered
+	class lazy_document {
+	private:
+		struct entry {
+			std::string_view key;
+			// the whole statement, from its key to its ';'
+			std::string_view statement;
+			int line;
+			int collumn;
+
+			bool decoded;
+			value cached;
+		};
+
+		std::string_view _input;
+		mapped_file _file;
+		std::vector<entry> _entries;
+		// statements of the keys already in the entries, only parsed by to_map to report their errors
+		std::vector<entry> _duplicates;
+		// values parsed at load, from the first malformed statement on
+		std::map<std::string, value> _rest;
+		std::size_t _decoded = 0;
+
+		lexer _lexer;
+		statement_scanner _scanner;
+		value_parser _parser;
+
+		void index();
+		// index past the ';' that ends the value starting at begin, npos if the value is not ended or
+		// its brackets do not match
+		std::size_t skip_value(std::size_t);
+		void parse_rest(std::size_t, int, int);
+		// sorts the entries like a std::map, moving the later statements of a key to the duplicates
+		void sort_entries();
+		// parses the statement of an entry into value, when given. A malformed statement is parsed again
+		// with the rest of the input, which replaces the entries from it on, and false is returned
+		bool parse_statement(const entry&, value*);
+		bool decode(std::size_t);
+		// index of the entry of key, npos if missing
+		std::size_t position(std::string_view) const;
+
+	public:
+		static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+		lazy_document() = default;
+
+		// indexes input, which is not copied and must outlive the document
+		void load(std::string_view);
+		// indexes the file, which is held by the document
+		void load(mapped_file&&);
+
+		// the keys, sorted as a std::map would iterate them
+		std::vector<std::string_view> keys() const;
+		std::size_t size() const noexcept;
+		bool contains(std::string_view) const;
+
+		// the value of key, parsed on its first read, nullptr if the key is missing
+		const value* find(std::string_view);
+		const value& at(std::string_view);
+
+		// parses every value not read yet, and the later values of duplicated keys, in the order of the
+		// input, so it reports the errors a parse would
+		std::map<std::string, value> to_map();
+
+		// number of values already parsed
+		std::size_t decoded() const noexcept;
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+	};
+
+}
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "bps_parallel.hpp"
+
+namespace bps_core {
+
+	void run_workers(unsigned int count, const std::function<void(unsigned int)>& work) {
+		auto workers = std::vector<std::thread>();
+		for (auto i = 1u; i < count; ++i) {
+			workers.emplace_back(work, i);
+		}
+		if (count > 0) {
+			work(0);
+		}
+		for (auto& w : workers) {
+			w.join();
+		}
+	}
+
+	std::vector<std::size_t> split_statements(std::string_view input, unsigned int parts) {
+		struct region {
+			std::size_t begin;
+			std::size_t end;
+			// index past the last statement end in the region, 0 if it has none
+			std::size_t split;
+			statement_scanner scanner;
+		};
+
+		parts = (unsigned int)std::clamp<std::size_t>(input.length(), 1, std::max(parts, 1u));
+		auto regions = std::vector<region>(parts);
+		for (auto i = 0u; i < parts; ++i) {
+			regions[i].begin = input.length() * i / parts;
+			regions[i].end = input.length() * (i + 1) / parts;
+		}
+
+		run_workers(parts, [&](unsigned int i) {
+			auto& r = regions[i];
+			r.scanner.reset(r.begin > 0 ? input[r.begin - 1] : '\0');
+			r.split = r.scanner.scan(input.substr(r.begin, r.end - r.begin));
+		});
+
+		// only the first region is known to start out of strings, chars and comments, a region whose
+		// predecessor ended inside one of them is scanned again carrying on from its state
+		for (auto i = 1u; i < parts; ++i) {
+			if (!regions[i - 1].scanner.in_data()) {
+				auto& r = regions[i];
+				r.scanner = regions[i - 1].scanner;
+				r.split = r.scanner.scan(input.substr(r.begin, r.end - r.begin));
+			}
+		}
+
+		auto ends = std::vector<std::size_t>();
+		for (auto i = 0u; i + 1 < parts; ++i) {
+			auto end = regions[i].begin + regions[i].split;
+			if (regions[i].split > 0 and end < input.length()) {
+				ends.push_back(end);
+			}
+		}
+		ends.push_back(input.length());
+		return ends;
+	}
+
+}
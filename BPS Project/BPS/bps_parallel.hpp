@@ -0,0 +1,127 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_stream.hpp"
+
+
+namespace bps_core {
+
+	// calls work with each index below count, each call on its own thread, the calling thread included
+	void run_workers(unsigned int, const std::function<void(unsigned int)>&);
+
+	// splits input in at most the given number of parts, each ending right after a top level ';', and
+	// returns the end of each part. The input is cut in equal regions scanned on their own threads, each
+	// guessing it starts out of strings, chars and comments, the guesses are then checked in order and a
+	// region guessed wrong is scanned again from where the one before it really ended
+	std::vector<std::size_t> split_statements(std::string_view, unsigned int);
+
+	// parses a single document on many threads: the input is split at statement ends, each part is parsed
+	// by its own parser and the documents are merged in order, keeping the first value of a key.
+	// Inputs with syntax errors are parsed again by a single parser, so the document and the errors are
+	// the same as the ones of basic_parser. The Builder must build a std::map
+	template<class Builder>
+	class basic_parallel_parser {
+	private:
+		std::vector<basic_parser<Builder>> _parsers;
+		std::vector<typename Builder::document_type> _documents;
+
+		unsigned int _threads;
+		parse_options _options;
+
+	public:
+		// inputs are not split in parts smaller than this
+		static constexpr std::size_t MIN_PART_SIZE = 1024 * 1024;
+
+		// 0 threads uses the hardware concurrency
+		explicit basic_parallel_parser(unsigned int = 0);
+
+		typename Builder::document_type parse(std::string_view);
+
+		unsigned int threads() const noexcept;
+		void set_threads(unsigned int);
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+	};
+
+	using parallel_parser = basic_parallel_parser<any_builder>;
+	using value_parallel_parser = basic_parallel_parser<value_builder>;
+
+	template<class Builder>
+	basic_parallel_parser<Builder>::basic_parallel_parser(unsigned int threads)
+		: _threads(threads) {
+	}
+
+	template<class Builder>
+	typename Builder::document_type basic_parallel_parser<Builder>::parse(std::string_view data) {
+		auto threads = _threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : _threads;
+		threads = (unsigned int)std::clamp<std::size_t>(data.length() / MIN_PART_SIZE, 1, threads);
+
+		auto ends = threads > 1 ? split_statements(data, threads) : std::vector<std::size_t>{ data.length() };
+		auto parts = (unsigned int)ends.size();
+
+		if (_parsers.size() < parts) {
+			_parsers.resize(parts);
+		}
+		_documents.resize(parts);
+		for (auto& p : _parsers) {
+			p.set_options(_options);
+		}
+
+		if (parts > 1) {
+			auto clean = std::vector<char>(parts, false);
+			run_workers(parts, [&](unsigned int i) {
+				auto begin = i == 0 ? 0 : ends[i - 1];
+				auto& p = _parsers[i];
+				try {
+					// the location is only used by errors, which are reported by the single parser below
+					p.begin();
+					p.parse_part(data.substr(begin, ends[i] - begin), 1, 1);
+					clean[i] = !p.stopped() and !p.recovered();
+					_documents[i] = p.end();
+				}
+				catch (...) {
+					clean[i] = false;
+				}
+			});
+
+			if (std::all_of(clean.begin(), clean.end(), [](char c) { return c; })) {
+				// nodes are moved into the first document, merge keeps the keys it already has
+				auto document = std::move(_documents[0]);
+				for (auto i = 1u; i < parts; ++i) {
+					document.merge(_documents[i]);
+					_documents[i].clear();
+				}
+				return document;
+			}
+
+			for (auto& d : _documents) {
+				d.clear();
+			}
+		}
+
+		return _parsers[0].parse(data);
+	}
+
+	template<class Builder>
+	unsigned int basic_parallel_parser<Builder>::threads() const noexcept {
+		return _threads;
+	}
+
+	template<class Builder>
+	void basic_parallel_parser<Builder>::set_threads(unsigned int threads) {
+		_threads = threads;
+	}
+
+	template<class Builder>
+	const parse_options& basic_parallel_parser<Builder>::options() const {
+		return _options;
+	}
+
+	template<class Builder>
+	void basic_parallel_parser<Builder>::set_options(const parse_options& options) {
+		_options = options;
+	}
+
+}
@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "bps_records.hpp"
+
+namespace bps_core {
+
+	void record_framer::load(std::string_view data) {
+		_data = data;
+		_offset = 0;
+		_line = 1;
+		_line_offset = 0;
+		_line_begin = 0;
+	}
+
+	bool record_framer::next(std::string_view& record, int& line, int& collumn) {
+		while (_offset < _data.length()) {
+			auto begin = _offset;
+			auto end = find_end(begin);
+			auto found = _data.substr(begin, end - begin);
+			if (std::any_of(found.begin(), found.end(), [](char c) { return (unsigned char)c > symbols::SPACE; })) {
+				record = found;
+				locate(begin, line, collumn);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::size_t record_framer::find_end(std::size_t begin) {
+		// the record is only scanned up to each delimiter found, to tell whether it lies in a string,
+		// a char or a comment
+		_scanner.reset(begin > 0 ? _data[begin - 1] : '\0');
+		auto scanned = begin;
+		auto pos = begin;
+		auto end = std::size_t(0);
+		auto next = std::size_t(0);
+		while (find_delimiter(pos, end, next)) {
+			_scanner.scan(_data.substr(scanned, end - scanned));
+			scanned = end;
+			if (_scanner.in_data()) {
+				_offset = next;
+				return end;
+			}
+			pos = _delimiter.empty() ? end : end + 1;
+		}
+		_offset = _data.length();
+		return _data.length();
+	}
+
+	bool record_framer::find_delimiter(std::size_t pos, std::size_t& end, std::size_t& next) const {
+		if (!_delimiter.empty()) {
+			auto found = _data.find(_delimiter, pos);
+			if (found == std::string_view::npos) {
+				return false;
+			}
+			end = found;
+			next = found + _delimiter.length();
+			return true;
+		}
+
+		// the record ends with the newline before the blank line, so a comment on its last line is closed
+		for (auto i = _data.find(symbols::NEWLINE, pos); i != std::string_view::npos; i = _data.find(symbols::NEWLINE, i + 1)) {
+			auto j = i + 1;
+			while (j < _data.length() and (_data[j] == ' ' or _data[j] == '\t' or _data[j] == '\r')) {
+				++j;
+			}
+			if (j < _data.length() and _data[j] == symbols::NEWLINE) {
+				end = i + 1;
+				next = j + 1;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void record_framer::locate(std::size_t offset, int& line, int& collumn) {
+		// records are found in order, so the newlines are counted from the last one
+		auto part = _data.substr(_line_offset, offset - _line_offset);
+		auto newlines = std::count(part.begin(), part.end(), symbols::NEWLINE);
+		if (newlines > 0) {
+			_line += (int)newlines;
+			_line_begin = _line_offset + part.rfind(symbols::NEWLINE) + 1;
+		}
+		_line_offset = offset;
+		line = _line;
+		collumn = (int)(offset - _line_begin) + 1;
+	}
+
+	const std::string& record_framer::delimiter() const noexcept {
+		return _delimiter;
+	}
+
+	void record_framer::set_delimiter(std::string delimiter) {
+		_delimiter = std::move(delimiter);
+	}
+
+}
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_arena.hpp"
+#include "bps_file.hpp"
+#include "bps_stream.hpp"
+
+
+namespace bps_core {
+
+	// splits an input holding many documents back to back in records, at the delimiters that are out of
+	// strings, chars and comments. The default delimiter is a blank line, only spaces, tabs or '\r'.
+	// Records holding only whitespace are skipped
+	class record_framer {
+	private:
+		std::string_view _data;
+		std::size_t _offset = 0;
+		std::string _delimiter;
+
+		statement_scanner _scanner;
+
+		// line of the last record found and the offset it starts at, so newlines are only counted once
+		int _line = 1;
+		std::size_t _line_offset = 0;
+		std::size_t _line_begin = 0;
+
+		// end of the record starting at begin, moves the offset past its delimiter
+		std::size_t find_end(std::size_t);
+		// finds the first delimiter at or after pos, giving where the record before it ends and the next starts
+		bool find_delimiter(std::size_t, std::size_t&, std::size_t&) const;
+		void locate(std::size_t, int&, int&);
+
+	public:
+		void load(std::string_view);
+
+		// next record and the location of its first char in the input, false past the last one
+		bool next(std::string_view&, int&, int&);
+
+		const std::string& delimiter() const noexcept;
+		// an empty delimiter splits at blank lines
+		void set_delimiter(std::string);
+	};
+
+	// reads the documents of a record oriented buffer or file one record at a time, reusing one parser
+	// for all of them. Records can be parsed ahead on a thread of their own, set with set_prefetch before
+	// the first record is read. A record that fails to parse throws from the read that reaches it, and
+	// reading can go on from the record after it
+	template<class Builder>
+	class basic_record_reader {
+	public:
+		using document_type = typename Builder::document_type;
+
+		// input iterator over the records left, each read as the iterator is advanced
+		class iterator {
+		private:
+			basic_record_reader* _reader = nullptr;
+			document_type _document;
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = document_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = document_type*;
+			using reference = document_type&;
+
+			iterator() = default;
+			explicit iterator(basic_record_reader*);
+
+			document_type& operator*() noexcept;
+			document_type* operator->() noexcept;
+			iterator& operator++();
+			bool operator==(const iterator&) const noexcept;
+		};
+
+	private:
+		struct fetched_record {
+			document_type document;
+			std::exception_ptr error = nullptr;
+		};
+
+		basic_parser<Builder> _parser;
+		record_framer _framer;
+		mapped_file _file;
+
+		// records parsed ahead by the worker, at most _prefetch of them
+		std::size_t _prefetch = 0;
+		std::thread _worker;
+		std::mutex _mutex;
+		std::condition_variable _fetched;
+		std::condition_variable _taken;
+		std::deque<fetched_record> _queue;
+		bool _finished = false;
+		bool _stopping = false;
+
+		bool parse_next(document_type&);
+		// worker loop, parses the records into the queue until the input ends or the reader stops it
+		void fetch();
+		void stop();
+
+	public:
+		basic_record_reader() = default;
+		basic_record_reader(const basic_record_reader&) = delete;
+		basic_record_reader& operator=(const basic_record_reader&) = delete;
+		~basic_record_reader();
+
+		// reads the records of a buffer, which must outlive the reading
+		void load(std::string_view);
+		// reads the records of a file from its memory mapped pages
+		void open(const std::filesystem::path&);
+		void close();
+
+		// reads the next record into document, false past the last one
+		bool next(document_type&);
+		// replaces records with up to count records read, returns how many were read, 0 past the last one
+		std::size_t read_batch(std::vector<document_type>&, std::size_t);
+
+		iterator begin();
+		iterator end();
+
+		const std::string& delimiter() const noexcept;
+		void set_delimiter(std::string);
+
+		// number of records parsed ahead of the reads by a worker thread, 0 parses each record as it is read
+		std::size_t prefetch() const noexcept;
+		void set_prefetch(std::size_t);
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+
+		// reports the metrics of each record, nullptr stops reporting
+		void set_instrumentation(const instrumentation*);
+	};
+
+	using record_reader = basic_record_reader<any_builder>;
+	using value_record_reader = basic_record_reader<value_builder>;
+	using arena_record_reader = basic_record_reader<arena_builder>;
+
+	template<class Builder>
+	basic_record_reader<Builder>::iterator::iterator(basic_record_reader* reader)
+		: _reader(reader) {
+		++*this;
+	}
+
+	template<class Builder>
+	typename basic_record_reader<Builder>::document_type& basic_record_reader<Builder>::iterator::operator*() noexcept {
+		return _document;
+	}
+
+	template<class Builder>
+	typename basic_record_reader<Builder>::document_type* basic_record_reader<Builder>::iterator::operator->() noexcept {
+		return &_document;
+	}
+
+	template<class Builder>
+	typename basic_record_reader<Builder>::iterator& basic_record_reader<Builder>::iterator::operator++() {
+		if (!_reader->next(_document)) {
+			_reader = nullptr;
+		}
+		return *this;
+	}
+
+	template<class Builder>
+	bool basic_record_reader<Builder>::iterator::operator==(const iterator& other) const noexcept {
+		return _reader == other._reader;
+	}
+
+	template<class Builder>
+	basic_record_reader<Builder>::~basic_record_reader() {
+		stop();
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::load(std::string_view data) {
+		stop();
+		_file.close();
+		_framer.load(data);
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::open(const std::filesystem::path& path) {
+		stop();
+		_file = mapped_file(path);
+		_framer.load(_file.view());
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::close() {
+		stop();
+		_framer.load(std::string_view());
+		_file.close();
+	}
+
+	template<class Builder>
+	bool basic_record_reader<Builder>::parse_next(document_type& document) {
+		auto record = std::string_view();
+		int line, collumn;
+		if (!_framer.next(record, line, collumn)) {
+			return false;
+		}
+		_parser.begin();
+		_parser.parse_part(record, line, collumn);
+		document = _parser.end();
+		return true;
+	}
+
+	template<class Builder>
+	bool basic_record_reader<Builder>::next(document_type& document) {
+		if (_prefetch == 0) {
+			return parse_next(document);
+		}
+
+		// the worker is started by the first read, and left to end on its own at the end of the input
+		if (!_worker.joinable()) {
+			_worker = std::thread([this]() { fetch(); });
+		}
+
+		// the threads hand the records over in batches of half the queue, instead of waking each other per record
+		auto batch = std::max<std::size_t>(_prefetch / 2, 1);
+		auto lock = std::unique_lock(_mutex);
+		if (_queue.empty()) {
+			_fetched.wait(lock, [this, batch]() { return _queue.size() >= batch or _finished; });
+		}
+		if (_queue.empty()) {
+			return false;
+		}
+		auto record = std::move(_queue.front());
+		_queue.pop_front();
+		auto wake = _queue.size() == _prefetch - batch;
+		lock.unlock();
+		if (wake) {
+			_taken.notify_one();
+		}
+
+		if (record.error != nullptr) {
+			std::rethrow_exception(record.error);
+		}
+		document = std::move(record.document);
+		return true;
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::fetch() {
+		auto batch = std::max<std::size_t>(_prefetch / 2, 1);
+		while (true) {
+			auto record = fetched_record();
+			auto more = true;
+			try {
+				more = parse_next(record.document);
+			}
+			catch (...) {
+				record.error = std::current_exception();
+			}
+
+			auto lock = std::unique_lock(_mutex);
+			if (!more) {
+				_finished = true;
+				lock.unlock();
+				_fetched.notify_one();
+				return;
+			}
+			if (_queue.size() >= _prefetch) {
+				_taken.wait(lock, [this, batch]() { return _queue.size() <= _prefetch - batch or _stopping; });
+			}
+			if (_stopping) {
+				return;
+			}
+			_queue.push_back(std::move(record));
+			auto wake = _queue.size() == batch;
+			lock.unlock();
+			if (wake) {
+				_fetched.notify_one();
+			}
+		}
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::stop() {
+		if (_worker.joinable()) {
+			{
+				auto lock = std::unique_lock(_mutex);
+				_stopping = true;
+			}
+			_taken.notify_all();
+			_worker.join();
+		}
+		_queue.clear();
+		_finished = false;
+		_stopping = false;
+	}
+
+	template<class Builder>
+	std::size_t basic_record_reader<Builder>::read_batch(std::vector<document_type>& records, std::size_t count) {
+		// the documents already in records are assigned over, so the vector itself is not allocated again
+		records.resize(count);
+		auto read = std::size_t(0);
+		while (read < count and next(records[read])) {
+			++read;
+		}
+		records.resize(read);
+		return read;
+	}
+
+	template<class Builder>
+	typename basic_record_reader<Builder>::iterator basic_record_reader<Builder>::begin() {
+		return iterator(this);
+	}
+
+	template<class Builder>
+	typename basic_record_reader<Builder>::iterator basic_record_reader<Builder>::end() {
+		return iterator();
+	}
+
+	template<class Builder>
+	const std::string& basic_record_reader<Builder>::delimiter() const noexcept {
+		return _framer.delimiter();
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::set_delimiter(std::string delimiter) {
+		_framer.set_delimiter(std::move(delimiter));
+	}
+
+	template<class Builder>
+	std::size_t basic_record_reader<Builder>::prefetch() const noexcept {
+		return _prefetch;
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::set_prefetch(std::size_t prefetch) {
+		_prefetch = prefetch;
+	}
+
+	template<class Builder>
+	const parse_options& basic_record_reader<Builder>::options() const {
+		return _parser.options();
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::set_options(const parse_options& options) {
+		_parser.set_options(options);
+	}
+
+	template<class Builder>
+	void basic_record_reader<Builder>::set_instrumentation(const instrumentation* instrumentation) {
+		_parser.set_instrumentation(instrumentation);
+	}
+
+}
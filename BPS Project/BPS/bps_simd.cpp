@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "bps_simd.hpp"
+
+#ifdef BPS_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BPS_TARGET_AVX2
+#else
+#define BPS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace bps_core {
+
+	enum char_class : std::uint16_t {
+		C_WHITESPACE = 1 << 0,
+		C_NEWLINE = 1 << 1,
+		C_STRUCTURAL = 1 << 2,
+		C_DQUOTE = 1 << 3,
+		C_QUOTE = 1 << 4,
+		C_HASH = 1 << 5,
+		C_BACKSLASH = 1 << 6,
+		C_IDENT = 1 << 7,
+		C_NUMBER = 1 << 8
+	};
+
+	struct char_class_table {
+		std::uint16_t classes[256];
+
+		char_class_table() : classes() {
+			for (auto c : { ' ', '\t', '\n', '\r' }) {
+				classes[(unsigned char)c] |= C_WHITESPACE;
+			}
+			classes['\n'] |= C_NEWLINE;
+			for (auto c : { ':', ';', '[', ']', ',' }) {
+				classes[(unsigned char)c] |= C_STRUCTURAL;
+			}
+			classes['"'] |= C_DQUOTE;
+			classes['\''] |= C_QUOTE;
+			classes['#'] |= C_HASH;
+			classes['\\'] |= C_BACKSLASH;
+			for (auto c = 'a'; c <= 'z'; ++c) {
+				classes[(unsigned char)c] |= C_IDENT;
+			}
+			for (auto c = 'A'; c <= 'Z'; ++c) {
+				classes[(unsigned char)c] |= C_IDENT;
+			}
+			for (auto c = '0'; c <= '9'; ++c) {
+				classes[(unsigned char)c] |= C_IDENT | C_NUMBER;
+			}
+			classes['_'] |= C_IDENT;
+			classes['.'] |= C_NUMBER;
+		}
+	};
+
+	const static char_class_table CHAR_CLASSES;
+
+	void scan_block_scalar(const char* block, block_masks& masks) {
+		masks = block_masks();
+		for (std::size_t i = 0; i < BLOCK_SIZE; ++i) {
+			auto classes = CHAR_CLASSES.classes[(unsigned char)block[i]];
+			auto bit = std::uint64_t(1) << i;
+			if (classes == 0) {
+				continue;
+			}
+			if (classes & C_WHITESPACE) masks.whitespace |= bit;
+			if (classes & C_NEWLINE) masks.newline |= bit;
+			if (classes & C_STRUCTURAL) masks.structural |= bit;
+			if (classes & C_DQUOTE) masks.dquote |= bit;
+			if (classes & C_QUOTE) masks.quote |= bit;
+			if (classes & C_HASH) masks.hash |= bit;
+			if (classes & C_BACKSLASH) masks.backslash |= bit;
+			if (classes & C_IDENT) masks.ident |= bit;
+			if (classes & C_NUMBER) masks.number |= bit;
+		}
+	}
+
+#ifdef BPS_SIMD_X86
+
+	// signed compares leave bytes above 127 out of every ascii range
+	static inline __m128i sse2_range(__m128i v, char low, char high) {
+		return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+	}
+
+	static inline std::uint64_t sse2_bits(__m128i v, std::size_t part) {
+		return (std::uint64_t)(std::uint16_t)_mm_movemask_epi8(v) << (part * 16);
+	}
+
+	void scan_block_sse2(const char* block, block_masks& masks) {
+		masks = block_masks();
+		for (std::size_t part = 0; part < BLOCK_SIZE / 16; ++part) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + part * 16));
+
+			auto newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+			auto whitespace = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(newline, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+			auto structural = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(';'))),
+				_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']'))),
+					_mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+			auto digit = sse2_range(v, '0', '9');
+			auto ident = _mm_or_si128(
+				_mm_or_si128(sse2_range(v, 'a', 'z'), sse2_range(v, 'A', 'Z')),
+				_mm_or_si128(digit, _mm_cmpeq_epi8(v, _mm_set1_epi8('_'))));
+			auto number = _mm_or_si128(digit, _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+
+			masks.whitespace |= sse2_bits(whitespace, part);
+			masks.newline |= sse2_bits(newline, part);
+			masks.structural |= sse2_bits(structural, part);
+			masks.dquote |= sse2_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), part);
+			masks.quote |= sse2_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')), part);
+			masks.hash |= sse2_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')), part);
+			masks.backslash |= sse2_bits(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')), part);
+			masks.ident |= sse2_bits(ident, part);
+			masks.number |= sse2_bits(number, part);
+		}
+	}
+
+	BPS_TARGET_AVX2 static inline __m256i avx2_eq(__m256i v, char c) {
+		return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+	}
+
+	BPS_TARGET_AVX2 static inline __m256i avx2_range(__m256i v, char low, char high) {
+		return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), v));
+	}
+
+	BPS_TARGET_AVX2 static inline std::uint64_t avx2_bits(__m256i v, std::size_t part) {
+		return (std::uint64_t)(std::uint32_t)_mm256_movemask_epi8(v) << (part * 32);
+	}
+
+	BPS_TARGET_AVX2 void scan_block_avx2(const char* block, block_masks& masks) {
+		masks = block_masks();
+		for (std::size_t part = 0; part < BLOCK_SIZE / 32; ++part) {
+			auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + part * 32));
+
+			auto newline = avx2_eq(v, '\n');
+			auto whitespace = _mm256_or_si256(_mm256_or_si256(avx2_eq(v, ' '), avx2_eq(v, '\t')), _mm256_or_si256(newline, avx2_eq(v, '\r')));
+			auto structural = _mm256_or_si256(
+				_mm256_or_si256(avx2_eq(v, ':'), avx2_eq(v, ';')),
+				_mm256_or_si256(_mm256_or_si256(avx2_eq(v, '['), avx2_eq(v, ']')), avx2_eq(v, ',')));
+			auto digit = avx2_range(v, '0', '9');
+			auto ident = _mm256_or_si256(
+				_mm256_or_si256(avx2_range(v, 'a', 'z'), avx2_range(v, 'A', 'Z')),
+				_mm256_or_si256(digit, avx2_eq(v, '_')));
+			auto number = _mm256_or_si256(digit, avx2_eq(v, '.'));
+
+			masks.whitespace |= avx2_bits(whitespace, part);
+			masks.newline |= avx2_bits(newline, part);
+			masks.structural |= avx2_bits(structural, part);
+			masks.dquote |= avx2_bits(avx2_eq(v, '"'), part);
+			masks.quote |= avx2_bits(avx2_eq(v, '\''), part);
+			masks.hash |= avx2_bits(avx2_eq(v, '#'), part);
+			masks.backslash |= avx2_bits(avx2_eq(v, '\\'), part);
+			masks.ident |= avx2_bits(ident, part);
+			masks.number |= avx2_bits(number, part);
+		}
+	}
+
+	static bool cpu_has_avx2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		// the os must save the ymm registers
+		auto osxsave = (info[2] & (1 << 27)) != 0;
+		auto avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave or !avx or (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+#endif
+
+	using scan_block_function = void (*)(const char*, block_masks&);
+
+	struct scan_block_dispatch {
+		scan_block_function function;
+		const char* name;
+
+		scan_block_dispatch() {
+#ifdef BPS_SIMD_X86
+			if (cpu_has_avx2()) {
+				function = scan_block_avx2;
+				name = "avx2";
+			}
+			else {
+				function = scan_block_sse2;
+				name = "sse2";
+			}
+#else
+			function = scan_block_scalar;
+			name = "scalar";
+#endif
+		}
+	};
+
+	static const scan_block_dispatch& dispatch() {
+		static const scan_block_dispatch chosen;
+		return chosen;
+	}
+
+	void scan_block(const char* block, block_masks& masks) {
+		dispatch().function(block, masks);
+	}
+
+	void scan_block(std::string_view input, std::size_t index, block_masks& masks) {
+		if (index + BLOCK_SIZE <= input.length()) {
+			scan_block(input.data() + index, masks);
+			return;
+		}
+
+		// the last block is padded with zeros, which belong to no class
+		char padded[BLOCK_SIZE] = {};
+		if (index < input.length()) {
+			std::memcpy(padded, input.data() + index, input.length() - index);
+		}
+		scan_block(padded, masks);
+	}
+
+	const char* simd_implementation() {
+		return dispatch().name;
+	}
+
+}
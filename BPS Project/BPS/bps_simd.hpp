@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pch.h"
+
+
+namespace bps_core {
+
+	const std::size_t BLOCK_SIZE = 64;
+
+	// one bit per byte of a 64 byte input block, bit i is set when byte i belongs to the class
+	struct block_masks {
+		std::uint64_t whitespace;
+		std::uint64_t newline;
+		// : ; [ ] ,
+		std::uint64_t structural;
+		std::uint64_t dquote;
+		std::uint64_t quote;
+		std::uint64_t hash;
+		std::uint64_t backslash;
+		// alphanumeric or underscore, the chars of a key
+		std::uint64_t ident;
+		// digits or dot, the chars of a numeric literal
+		std::uint64_t number;
+	};
+
+	void scan_block_scalar(const char*, block_masks&);
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BPS_SIMD_X86
+	void scan_block_sse2(const char*, block_masks&);
+	void scan_block_avx2(const char*, block_masks&);
+#endif
+
+	// scans a full block with the best implementation the running cpu supports
+	void scan_block(const char*, block_masks&);
+
+	// scans the block starting at index, bytes past the end of input belong to no class
+	void scan_block(std::string_view, std::size_t, block_masks&);
+
+	// name of the implementation chosen by scan_block: "avx2", "sse2" or "scalar"
+	const char* simd_implementation();
+
+	// quotes that are not preceded by a backslash, carry tells whether the byte before the block is a backslash
+	inline std::uint64_t unescaped_quotes(const block_masks& block, bool carry) {
+		return block.dquote & ~((block.backslash << 1) | (carry ? 1 : 0));
+	}
+
+}
@@ -0,0 +1,263 @@
+#include "pch.h"
+#include "bps_source.hpp"
+
+namespace bps_core {
+
+	void source_document::load(std::string source) {
+		_source = std::move(source);
+		index();
+	}
+
+	void source_document::index() {
+		_statements.clear();
+		_index.clear();
+		_changed.clear();
+		_edited = false;
+
+		auto tok = token_view();
+		_lexer.load(_source);
+		_lexer.next_token(tok);
+		while (tok.category == token_category::T_KEY) {
+			auto s = statement();
+			s.begin = tok.offset;
+			s.key_end = tok.offset + tok.length;
+			_lexer.location(tok.offset, s.line, s.collumn);
+
+			_lexer.next_token(tok);
+			if (tok.category != token_category::T_DATA_SEP) {
+				malformed(tok);
+			}
+			_lexer.next_token(tok);
+			s.value_begin = tok.offset;
+			if (!scan_value(_lexer, tok)) {
+				malformed(tok);
+			}
+
+			// the value ends at its last token, the whitespace before the ';' is kept
+			s.value_end = tok.offset;
+			while (s.value_end > s.value_begin and (unsigned char)_source[s.value_end - 1] <= symbols::SPACE) {
+				--s.value_end;
+			}
+			s.end = tok.offset + tok.length;
+
+			auto i = _statements.size();
+			_statements.push_back(std::move(s));
+			auto k = key(_statements.back());
+			if (!_index.try_emplace(k, std::size_t(i))) {
+				// the parser keeps the first value of a key, the later ones are only chained to be erased with it
+				auto d = *_index.find(k);
+				while (_statements[d].duplicate != npos) {
+					d = _statements[d].duplicate;
+				}
+				_statements[d].duplicate = i;
+			}
+			_lexer.next_token(tok);
+		}
+
+		if (tok.category != token_category::T_EOF) {
+			malformed(tok);
+		}
+	}
+
+	void source_document::malformed(const token_view& tok) {
+		int line, collumn;
+		_lexer.location(tok.offset, line, collumn);
+		throw std::invalid_argument(build_parser_error_message(std::string(_lexer.image(tok)), line, collumn, "statement"));
+	}
+
+	const source_document::statement& source_document::locate(std::string_view k) const {
+		auto found = _index.find(k);
+		if (found == nullptr or _statements[*found].erased) {
+			std::stringstream msg;
+			msg << "Key '";
+			msg << k;
+			msg << "' not found.";
+			throw std::out_of_range(msg.str());
+		}
+		return _statements[*found];
+	}
+
+	std::string_view source_document::key(const statement& s) const {
+		if (s.added) {
+			return s.key;
+		}
+		return std::string_view(_source).substr(s.begin, s.key_end - s.begin);
+	}
+
+	void source_document::change(std::size_t i) {
+		auto& s = _statements[i];
+		if (!s.added and !s.edited and !s.erased) {
+			_changed.push_back(i);
+		}
+		_edited = true;
+	}
+
+	std::vector<std::string_view> source_document::keys() const {
+		auto keys = std::vector<std::string_view>();
+		keys.reserve(_index.size());
+		for (auto i = std::size_t(0); i < _statements.size(); ++i) {
+			auto& s = _statements[i];
+			auto k = key(s);
+			if (!s.erased and *_index.find(k) == i) {
+				keys.push_back(k);
+			}
+		}
+		return keys;
+	}
+
+	std::size_t source_document::size() const noexcept {
+		auto count = std::size_t(0);
+		for (auto& entry : _index) {
+			count += _statements[entry.second].erased ? 0 : 1;
+		}
+		return count;
+	}
+
+	bool source_document::contains(std::string_view k) const {
+		auto found = _index.find(k);
+		return found != nullptr and !_statements[*found].erased;
+	}
+
+	std::string_view source_document::text(std::string_view k) const {
+		auto& s = locate(k);
+		if (s.added or s.edited) {
+			return s.text;
+		}
+		return std::string_view(_source).substr(s.value_begin, s.value_end - s.value_begin);
+	}
+
+	value source_document::read(std::string_view k) {
+		auto& s = locate(k);
+		_parser.begin();
+		if (s.added or s.edited) {
+			auto line = std::string(k);
+			line += ':';
+			line += s.text;
+			line += ';';
+			_parser.parse_part(line, s.line, s.collumn);
+		}
+		else {
+			_parser.parse_part(std::string_view(_source).substr(s.begin, s.end - s.begin), s.line, s.collumn);
+		}
+		auto parsed = _parser.end();
+		auto found = parsed.find(std::string(k));
+		if (found == parsed.end()) {
+			return value();
+		}
+		return std::move(found->second);
+	}
+
+	void source_document::set(std::string_view k, const value& v) {
+		auto text = std::string();
+		_plain.write_value(v, text);
+		set_text(k, std::move(text));
+	}
+
+	void source_document::set(std::string_view k, const std::any& v) {
+		auto text = std::string();
+		_plain.write_value(v, text);
+		set_text(k, std::move(text));
+	}
+
+	void source_document::set_text(std::string_view k, std::string&& text) {
+		auto found = _index.find(k);
+		if (found != nullptr) {
+			change(*found);
+			auto& s = _statements[*found];
+			s.text = std::move(text);
+			s.edited = true;
+			s.erased = false;
+			return;
+		}
+
+		// an added key must read back as a single key token
+		auto tok = token_view();
+		_lexer.load(k);
+		_lexer.next_token(tok);
+		if (tok.category != token_category::T_KEY or tok.length != k.length()) {
+			std::stringstream msg;
+			msg << "Invalid key '";
+			msg << k;
+			msg << "'.";
+			throw std::invalid_argument(msg.str());
+		}
+
+		auto& s = _statements.emplace_back();
+		s.added = true;
+		s.key = k;
+		s.text = std::move(text);
+		_index.try_emplace(k, _statements.size() - 1);
+		_edited = true;
+	}
+
+	bool source_document::erase(std::string_view k) {
+		auto found = _index.find(k);
+		if (found == nullptr or _statements[*found].erased) {
+			return false;
+		}
+		for (auto i = *found; i != npos; i = _statements[i].duplicate) {
+			change(i);
+			_statements[i].erased = true;
+		}
+		return true;
+	}
+
+	bool source_document::edited() const noexcept {
+		return _edited;
+	}
+
+	void source_document::write(std::string& output) const {
+		// only the changed statements are visited, the source between them is copied at once
+		auto changed = _changed;
+		std::sort(changed.begin(), changed.end(), [this](std::size_t a, std::size_t b) {
+			return _statements[a].begin < _statements[b].begin;
+		});
+
+		auto last = std::size_t(0);
+		for (auto i : changed) {
+			auto& s = _statements[i];
+			if (s.erased) {
+				output.append(_source, last, s.begin - last);
+				// with the blanks after it up to the end of its line
+				last = s.end;
+				while (last < _source.length() and (_source[last] == ' ' or _source[last] == '\t')) {
+					++last;
+				}
+				if (_source.compare(last, 2, "\r\n") == 0) {
+					last += 2;
+				}
+				else if (last < _source.length() and _source[last] == '\n') {
+					++last;
+				}
+			}
+			else {
+				output.append(_source, last, s.value_begin - last);
+				output += s.text;
+				last = s.value_end;
+			}
+		}
+		output.append(_source, last);
+
+		for (auto& s : _statements) {
+			if (!s.added or s.erased) {
+				continue;
+			}
+			if (!output.empty() and output.back() != '\n') {
+				output += '\n';
+			}
+			output += s.key;
+			output += ':';
+			output += s.text;
+			output += ";\n";
+		}
+	}
+
+	const parse_options& source_document::options() const {
+		return _parser.options();
+	}
+
+	void source_document::set_options(const parse_options& options) {
+		_parser.set_options(options);
+	}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+
+
+namespace bps_core {
+
+	// document that keeps its source text and the location of each statement. Edits only replace the
+	// text of the values they change, writing it back copies everything else as it was, keeping
+	// comments, whitespace and the order of the statements
+	class source_document {
+	public:
+		static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+	private:
+		struct statement {
+			// offsets in the source of the statement, from its key to its ';', and of its value
+			std::size_t begin = 0;
+			std::size_t key_end = 0;
+			std::size_t value_begin = 0;
+			std::size_t value_end = 0;
+			std::size_t end = 0;
+			int line = 1;
+			int collumn = 1;
+
+			// later statement with the same key, ignored by the parser, npos if none
+			std::size_t duplicate = npos;
+
+			bool edited = false;
+			bool erased = false;
+			// added statements are not in the source, they are written after it
+			bool added = false;
+			std::string key;
+			// plain text of the value of edited and added statements
+			std::string text;
+		};
+
+		std::string _source;
+		// statements of the source in their order, then the added ones
+		std::vector<statement> _statements;
+		// first statement of each key
+		flat_map<std::size_t> _index;
+		// source statements edited or erased since load, in the order they were first changed
+		std::vector<std::size_t> _changed;
+		bool _edited = false;
+
+		lexer _lexer;
+		value_parser _parser;
+		plain _plain;
+
+		void index();
+		[[noreturn]] void malformed(const token_view&);
+		// statement of key, throws when the key is missing
+		const statement& locate(std::string_view) const;
+		std::string_view key(const statement&) const;
+		void change(std::size_t);
+		void set_text(std::string_view, std::string&&);
+
+	public:
+		source_document() = default;
+
+		// indexes source, which is kept by the document. Malformed statements throw, since
+		// the document could not tell which text their edits replace
+		void load(std::string);
+
+		// the keys, in the order of their statements
+		std::vector<std::string_view> keys() const;
+		std::size_t size() const noexcept;
+		bool contains(std::string_view) const;
+
+		// plain text of the value of key, as in the source or as last set
+		std::string_view text(std::string_view) const;
+		// parses the value of key
+		value read(std::string_view);
+
+		// replaces the value of key, or adds a statement for it after the source
+		void set(std::string_view, const value&);
+		void set(std::string_view, const std::any&);
+		// removes the statements of key, returns whether there was one
+		bool erase(std::string_view);
+
+		// whether the document was changed since load
+		bool edited() const noexcept;
+
+		// appends the source with the changes spliced in
+		void write(std::string&) const;
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+	};
+
+}
@@ -0,0 +1,26 @@
+#include "pch.h"
+#include "bps_stream.hpp"
+
+namespace bps_core {
+
+	void statement_scanner::reset(char before) {
+		_state = scan_state::S_DATA;
+		_before = before;
+	}
+
+	bool statement_scanner::in_data() const noexcept {
+		return _state == scan_state::S_DATA;
+	}
+
+	std::size_t statement_scanner::scan(std::string_view chunk) {
+		auto end = std::size_t(0);
+		walk(chunk, [&](std::size_t index, char c) {
+			if (c == symbols::SEMICOLON) {
+				end = index + 1;
+			}
+			return true;
+		});
+		return end;
+	}
+
+}
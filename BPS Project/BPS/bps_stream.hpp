@@ -0,0 +1,274 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+#include "bps_arena.hpp"
+#include "bps_validate.hpp"
+
+
+namespace bps_core {
+
+	// finds the ';' that end top level statements in input given chunk by chunk,
+	// strings, chars and comments split across chunks are carried over to the next one
+	class statement_scanner {
+	private:
+		enum scan_state : std::uint8_t {
+			S_DATA = 0,
+			S_STRING = 1,
+			// char literal, after its opening quote, after its escape char and before its closing quote
+			S_CHAR = 2,
+			S_CHAR_ESCAPED = 3,
+			S_CHAR_CLOSE = 4,
+			S_COMMENT = 5
+		};
+
+		scan_state _state = scan_state::S_DATA;
+		// last char of the previous chunk, it escapes a quote at the start of the next one
+		char _before = '\0';
+
+	public:
+		// starts out of strings, chars and comments, before is the char right before the next chunk
+		void reset(char before = '\0');
+
+		// index past the last statement end in the chunk, 0 if the chunk ends none
+		std::size_t scan(std::string_view);
+
+		// whether the chunks scanned so far end out of strings, chars and comments
+		bool in_data() const noexcept;
+
+		// visits the ':', ';', '[', ']' and ',' of chunk that are out of strings, chars and comments, with
+		// their index, until visit returns false for one. Returns its index, or the chunk length when all
+		// were visited. A walk stopped early leaves the scanner in the middle of the chunk, to be reset
+		template<class Visit>
+		std::size_t walk(std::string_view, Visit&&);
+	};
+
+	// parses input pushed chunk by chunk, each complete statement is parsed as soon as its ';' arrives,
+	// only the statement still incomplete is buffered. The statements are validated before they are
+	// parsed, since the recovery from a syntax error depends on the input that follows it: from the first
+	// invalid statement on, the input is buffered and parsed by finish as a single part, so the document
+	// and the errors are the ones of basic_parser whatever the chunks
+	template<class Builder>
+	class basic_push_parser {
+	private:
+		basic_parser<Builder> _parser;
+		statement_scanner _scanner;
+		validator _validator;
+
+		std::string _pending;
+		bool _started = false;
+		// whether a part was invalid, all the input from it on is then pending
+		bool _invalid = false;
+
+		// location of the first pending char in the whole input
+		int _line = 1;
+		int _collumn = 1;
+
+		// parses a part of complete statements, false if it is invalid and was left for finish
+		bool parse_part(std::string_view);
+
+	public:
+		// parses the complete statements of chunk, keeping the incomplete one for the next chunks
+		void feed(std::string_view);
+
+		// parses whatever is still pending and takes the document, the parser can then be fed a new input
+		typename Builder::document_type finish();
+
+		// bytes held for the incomplete statement, or since the first invalid one
+		std::size_t pending() const noexcept;
+
+		const parse_options& options() const;
+		void set_options(const parse_options&);
+
+		// reports the metrics of each document, from its first feed to finish, nullptr stops reporting
+		void set_instrumentation(const instrumentation*);
+	};
+
+	using push_parser = basic_push_parser<any_builder>;
+	using value_push_parser = basic_push_parser<value_builder>;
+	using arena_push_parser = basic_push_parser<arena_builder>;
+
+	template<class Visit>
+	std::size_t statement_scanner::walk(std::string_view chunk, Visit&& visit) {
+		auto masks = block_masks();
+
+		for (auto block_index = std::size_t(0); block_index < chunk.length(); block_index += BLOCK_SIZE) {
+			scan_block(chunk, block_index, masks);
+			auto block_end = std::min(block_index + BLOCK_SIZE, chunk.length());
+
+			// only the chars that can change the state are visited, the others are skipped a block at a time
+			auto index = block_index;
+			while (index < block_end) {
+				auto offset = index - block_index;
+				auto candidates = std::uint64_t(0);
+				switch (_state) {
+				case scan_state::S_DATA:
+					candidates = masks.structural | masks.dquote | masks.quote | masks.hash;
+					break;
+				case scan_state::S_STRING:
+					candidates = masks.dquote;
+					break;
+				case scan_state::S_COMMENT:
+					candidates = masks.newline;
+					break;
+				default:
+					// char literals are read one char at a time
+					candidates = ~std::uint64_t(0);
+				}
+				candidates >>= offset;
+				if (candidates == 0) {
+					break;
+				}
+				index += std::countr_zero(candidates);
+				if (index >= block_end) {
+					break;
+				}
+
+				auto c = chunk[index];
+				auto before = index > 0 ? chunk[index - 1] : _before;
+				switch (_state) {
+				case scan_state::S_DATA:
+					if (c == symbols::DQUOTE) {
+						_state = scan_state::S_STRING;
+					}
+					else if (c == symbols::QUOTE) {
+						_state = scan_state::S_CHAR;
+					}
+					else if (c == symbols::HASH) {
+						_state = scan_state::S_COMMENT;
+					}
+					else if (!visit(index, c)) {
+						return index;
+					}
+					break;
+				case scan_state::S_STRING:
+					// as in the lexer, a quote is escaped by a backslash right before it
+					if (before != '\\') {
+						_state = scan_state::S_DATA;
+					}
+					break;
+				case scan_state::S_CHAR:
+					_state = c == '\\' ? scan_state::S_CHAR_ESCAPED : scan_state::S_CHAR_CLOSE;
+					break;
+				case scan_state::S_CHAR_ESCAPED:
+					_state = scan_state::S_CHAR_CLOSE;
+					break;
+				case scan_state::S_CHAR_CLOSE:
+					_state = scan_state::S_DATA;
+					// a char that is not closed is a lexer error, its next char is read as data
+					if (c != symbols::QUOTE) {
+						continue;
+					}
+					break;
+				case scan_state::S_COMMENT:
+					_state = scan_state::S_DATA;
+					break;
+				}
+				++index;
+			}
+		}
+
+		if (!chunk.empty()) {
+			_before = chunk.back();
+		}
+		return chunk.length();
+	}
+
+
+	template<class Builder>
+	void basic_push_parser<Builder>::feed(std::string_view chunk) {
+		if (!_started) {
+			_parser.begin();
+			_started = true;
+		}
+
+		if (_invalid) {
+			_pending.append(chunk);
+			return;
+		}
+
+		auto end = _scanner.scan(chunk);
+
+		// nothing pending, the statements are parsed straight from the chunk
+		if (_pending.empty()) {
+			if (end > 0 and !parse_part(chunk.substr(0, end))) {
+				_pending.assign(chunk);
+				return;
+			}
+			_pending.assign(chunk.substr(end));
+			return;
+		}
+
+		if (end == 0) {
+			_pending.append(chunk);
+			return;
+		}
+		_pending.append(chunk.substr(0, end));
+		if (!parse_part(_pending)) {
+			_pending.append(chunk.substr(end));
+			return;
+		}
+		_pending.assign(chunk.substr(end));
+	}
+
+	template<class Builder>
+	typename Builder::document_type basic_push_parser<Builder>::finish() {
+		if (!_started) {
+			_parser.begin();
+		}
+		// the last part runs to the end of the input, as in a single parse, so it is not validated
+		if (!_pending.empty()) {
+			_parser.parse_part(_pending, _line, _collumn);
+		}
+
+		_pending.clear();
+		_scanner.reset();
+		_started = false;
+		_invalid = false;
+		_line = 1;
+		_collumn = 1;
+
+		return _parser.end();
+	}
+
+	template<class Builder>
+	bool basic_push_parser<Builder>::parse_part(std::string_view part) {
+		if (!_validator.validate(part)) {
+			_invalid = true;
+			return false;
+		}
+		_parser.parse_part(part, _line, _collumn);
+
+		// the next part starts where this one ended
+		auto newlines = std::count(part.begin(), part.end(), symbols::NEWLINE);
+		if (newlines > 0) {
+			_line += (int)newlines;
+			_collumn = (int)(part.length() - part.rfind(symbols::NEWLINE));
+		}
+		else {
+			_collumn += (int)part.length();
+		}
+		return true;
+	}
+
+	template<class Builder>
+	std::size_t basic_push_parser<Builder>::pending() const noexcept {
+		return _pending.length();
+	}
+
+	template<class Builder>
+	const parse_options& basic_push_parser<Builder>::options() const {
+		return _parser.options();
+	}
+
+	template<class Builder>
+	void basic_push_parser<Builder>::set_options(const parse_options& options) {
+		_parser.set_options(options);
+	}
+
+	template<class Builder>
+	void basic_push_parser<Builder>::set_instrumentation(const instrumentation* instrumentation) {
+		_parser.set_instrumentation(instrumentation);
+	}
+
+}
@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "bps_validate.hpp"
+
+namespace bps_core {
+
+	validation_result validator::validate(std::string_view input) {
+		try {
+			_lexer.load(input);
+			next_token();
+			while (_tok.category != token_category::T_EOF) {
+				if (_tok.category != token_category::T_KEY) {
+					return error("key");
+				}
+				next_token();
+				if (_tok.category != token_category::T_DATA_SEP) {
+					return error("':'");
+				}
+				next_token();
+
+				auto depth = 0;
+				while (true) {
+					// opens the arrays before a value, an array closed right after it opens is empty
+					auto opened = false;
+					while (_tok.category == token_category::T_OPEN_ARRAY) {
+						++depth;
+						opened = true;
+						next_token();
+					}
+
+					switch (_tok.category) {
+					case token_category::T_STRING:
+					case token_category::T_CHAR:
+					case token_category::T_INTEGER:
+					case token_category::T_FLOAT:
+					case token_category::T_BOOL:
+					case token_category::T_NULL:
+						next_token();
+						break;
+					case token_category::T_CLOSE_ARRAY:
+						if (opened) {
+							break;
+						}
+						return error("a value or array");
+					default:
+						return error("a value or array");
+					}
+
+					// closes the arrays the value ends
+					while (depth > 0 and _tok.category == token_category::T_CLOSE_ARRAY) {
+						--depth;
+						next_token();
+					}
+					if (depth == 0) {
+						break;
+					}
+					if (_tok.category != token_category::T_ARRAY_SEP) {
+						return error("',' or ']'");
+					}
+					next_token();
+				}
+
+				if (_tok.category != token_category::T_END_OF_DATA) {
+					return error("';'");
+				}
+				next_token();
+			}
+		}
+		catch (const syntax_error& e) {
+			auto result = validation_result();
+			result.valid = false;
+			result.line = e.line();
+			result.collumn = e.collumn();
+			result.message = e.what();
+			return result;
+		}
+		return validation_result();
+	}
+
+	void validator::next_token() {
+		_lexer.next_token(_tok);
+	}
+
+	validation_result validator::error(std::string expected) {
+		auto result = validation_result();
+		result.valid = false;
+		_lexer.location(_tok.offset, result.line, result.collumn);
+		result.message = build_parser_error_message(std::string(_lexer.image(_tok)), result.line, result.collumn, expected);
+		return result;
+	}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+
+
+namespace bps_core {
+
+	// outcome of a validation, with the first error of a malformed input
+	struct validation_result {
+		bool valid = true;
+		int line = 0;
+		int collumn = 0;
+		std::string message;
+
+		explicit operator bool() const noexcept {
+			return valid;
+		}
+	};
+
+	// checks an input follows the BPS grammar without building anything: constants are only lexed,
+	// numbers are not decoded, so out of range numbers are not caught. Valid inputs are checked
+	// without allocating
+	class validator {
+	private:
+		lexer _lexer;
+		token_view _tok;
+
+		void next_token();
+		validation_result error(std::string);
+
+	public:
+		validation_result validate(std::string_view);
+	};
+
+}
@@ -0,0 +1,625 @@
+#include "pch.h"
+#include "bps_value.hpp"
+
+namespace bps_core {
+
+	const static std::string VALUE_TYPE_IMAGE[9] = {
+		"null",
+		"bool",
+		"char",
+		"integer",
+		"float",
+		"double",
+		"string",
+		"array",
+		"typed array"
+	};
+
+	std::string build_type_error_message(value_type type, value_type expected) {
+		std::stringstream msg;
+		msg << "Invalid type '";
+		msg << VALUE_TYPE_IMAGE[type];
+		msg << "'. Expected ";
+		msg << VALUE_TYPE_IMAGE[expected];
+		msg << ".";
+		return msg.str();
+	}
+
+	value::value() noexcept
+		: _type(value_type::V_NULL), _heap_string(false) {
+	}
+
+	value::value(std::nullptr_t) noexcept
+		: value() {
+	}
+
+	value::value(bool v) noexcept
+		: _type(value_type::V_BOOL), _heap_string(false) {
+		_storage.boolean = v;
+	}
+
+	value::value(char v) noexcept
+		: _type(value_type::V_CHAR), _heap_string(false) {
+		_storage.character = v;
+	}
+
+	value::value(int v) noexcept
+		: value((long long)v) {
+	}
+
+	value::value(long v) noexcept
+		: value((long long)v) {
+	}
+
+	value::value(long long v) noexcept
+		: _type(value_type::V_INT), _heap_string(false) {
+		_storage.integer = v;
+	}
+
+	value::value(float v) noexcept
+		: _type(value_type::V_FLOAT), _heap_string(false) {
+		_storage.single = v;
+	}
+
+	value::value(double v) noexcept
+		: _type(value_type::V_DOUBLE), _heap_string(false) {
+		_storage.real = v;
+	}
+
+	value::value(const char* v)
+		: value(std::string_view(v)) {
+	}
+
+	value::value(std::string_view v)
+		: _type(value_type::V_NULL), _heap_string(false) {
+		set_string(v);
+	}
+
+	value::value(const std::string& v)
+		: value(std::string_view(v)) {
+	}
+
+	value::value(array_type v)
+		: _type(value_type::V_ARRAY), _heap_string(false) {
+		new (&_storage.array) array_type(std::move(v));
+	}
+
+	value::value(typed_array v)
+		: _type(value_type::V_TYPED_ARRAY), _heap_string(false) {
+		_storage.typed = new typed_array(std::move(v));
+	}
+
+	value::value(const value& other)
+		: _type(value_type::V_NULL), _heap_string(false) {
+		switch (other._type) {
+		case value_type::V_STRING:
+			set_string(other.as_string());
+			break;
+		case value_type::V_ARRAY:
+			new (&_storage.array) array_type(other._storage.array);
+			_type = value_type::V_ARRAY;
+			break;
+		case value_type::V_TYPED_ARRAY:
+			_storage.typed = new typed_array(*other._storage.typed);
+			_type = value_type::V_TYPED_ARRAY;
+			break;
+		default:
+			std::memcpy(static_cast<void*>(&_storage), &other._storage, sizeof(storage));
+			_type = other._type;
+		}
+	}
+
+	value::value(value&& other) noexcept
+		: _type(value_type::V_NULL), _heap_string(false) {
+		move_from(other);
+	}
+
+	value& value::operator=(const value& other) {
+		if (this != &other) {
+			auto copy = value(other);
+			release();
+			move_from(copy);
+		}
+		return *this;
+	}
+
+	value& value::operator=(value&& other) noexcept {
+		if (this != &other) {
+			release();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	value::~value() {
+		release();
+	}
+
+	value_type value::type() const noexcept {
+		return _type;
+	}
+
+	bool value::is_null() const noexcept {
+		return _type == value_type::V_NULL;
+	}
+
+	bool value::as_bool() const {
+		if (_type != value_type::V_BOOL) {
+			invalid_type(value_type::V_BOOL);
+		}
+		return _storage.boolean;
+	}
+
+	char value::as_char() const {
+		if (_type != value_type::V_CHAR) {
+			invalid_type(value_type::V_CHAR);
+		}
+		return _storage.character;
+	}
+
+	std::int64_t value::as_int() const {
+		if (_type != value_type::V_INT) {
+			invalid_type(value_type::V_INT);
+		}
+		return _storage.integer;
+	}
+
+	float value::as_float() const {
+		if (_type != value_type::V_FLOAT) {
+			invalid_type(value_type::V_FLOAT);
+		}
+		return _storage.single;
+	}
+
+	double value::as_double() const {
+		// floats widen to double, so either float type can be read as double
+		if (_type == value_type::V_FLOAT) {
+			return _storage.single;
+		}
+		if (_type != value_type::V_DOUBLE) {
+			invalid_type(value_type::V_DOUBLE);
+		}
+		return _storage.real;
+	}
+
+	std::string_view value::as_string() const {
+		if (_type != value_type::V_STRING) {
+			invalid_type(value_type::V_STRING);
+		}
+		if (_heap_string) {
+			return std::string_view(_storage.heap.data, _storage.heap.size);
+		}
+		return std::string_view(_storage.small.data, _storage.small.size);
+	}
+
+	const value::array_type& value::as_array() const {
+		if (_type != value_type::V_ARRAY) {
+			invalid_type(value_type::V_ARRAY);
+		}
+		return _storage.array;
+	}
+
+	value::array_type& value::as_array() {
+		if (_type != value_type::V_ARRAY) {
+			invalid_type(value_type::V_ARRAY);
+		}
+		return _storage.array;
+	}
+
+	const typed_array& value::as_typed_array() const {
+		if (_type != value_type::V_TYPED_ARRAY) {
+			invalid_type(value_type::V_TYPED_ARRAY);
+		}
+		return *_storage.typed;
+	}
+
+	std::any value::to_any() const {
+		switch (_type) {
+		case value_type::V_BOOL:
+			return _storage.boolean;
+		case value_type::V_CHAR:
+			return _storage.character;
+		case value_type::V_INT:
+			return (long long)_storage.integer;
+		case value_type::V_FLOAT:
+			return _storage.single;
+		case value_type::V_DOUBLE:
+			return _storage.real;
+		case value_type::V_STRING:
+			return std::string(as_string());
+		case value_type::V_ARRAY: {
+			auto arr = std::vector<std::any>();
+			arr.reserve(_storage.array.size());
+			for (auto& v : _storage.array) {
+				arr.push_back(v.to_any());
+			}
+			return arr;
+		}
+		case value_type::V_TYPED_ARRAY:
+			return *_storage.typed;
+		default:
+			return nullptr;
+		}
+	}
+
+	value value::from_any(const std::any& v) {
+		if (v.type() == typeid(nullptr)) {
+			return value();
+		}
+		else if (v.type() == typeid(std::vector<std::any>)) {
+			auto& vec = *std::any_cast<std::vector<std::any>>(&v);
+			auto arr = array_type();
+			arr.reserve(vec.size());
+			for (auto& item : vec) {
+				arr.push_back(from_any(item));
+			}
+			return value(std::move(arr));
+		}
+		else if (v.type() == typeid(typed_array)) {
+			return value(*std::any_cast<typed_array>(&v));
+		}
+		else if (v.type() == typeid(std::string)) {
+			return value(*std::any_cast<std::string>(&v));
+		}
+		else if (v.type() == typeid(char)) {
+			return value(std::any_cast<char>(v));
+		}
+		else if (v.type() == typeid(bool)) {
+			return value(std::any_cast<bool>(v));
+		}
+		else if (v.type() == typeid(float)) {
+			return value(std::any_cast<float>(v));
+		}
+		else if (v.type() == typeid(double)) {
+			return value(std::any_cast<double>(v));
+		}
+		else if (v.type() == typeid(long double)) {
+			return value((double)std::any_cast<long double>(v));
+		}
+		else if (v.type() == typeid(short)) {
+			return value(std::any_cast<short>(v));
+		}
+		else if (v.type() == typeid(int)) {
+			return value(std::any_cast<int>(v));
+		}
+		else if (v.type() == typeid(long)) {
+			return value(std::any_cast<long>(v));
+		}
+		else if (v.type() == typeid(long long)) {
+			return value(std::any_cast<long long>(v));
+		}
+
+		std::stringstream msg;
+		msg << "Invalid type '";
+		msg << v.type().name();
+		msg << "'.";
+		throw std::invalid_argument(msg.str());
+	}
+
+	bool value::operator==(const value& other) const {
+		if (_type != other._type) {
+			return false;
+		}
+		switch (_type) {
+		case value_type::V_BOOL:
+			return _storage.boolean == other._storage.boolean;
+		case value_type::V_CHAR:
+			return _storage.character == other._storage.character;
+		case value_type::V_INT:
+			return _storage.integer == other._storage.integer;
+		case value_type::V_FLOAT:
+			return _storage.single == other._storage.single;
+		case value_type::V_DOUBLE:
+			return _storage.real == other._storage.real;
+		case value_type::V_STRING:
+			return as_string() == other.as_string();
+		case value_type::V_ARRAY:
+			return _storage.array == other._storage.array;
+		case value_type::V_TYPED_ARRAY:
+			return *_storage.typed == *other._storage.typed;
+		default:
+			return true;
+		}
+	}
+
+	void value::set_string(std::string_view v) {
+		if (v.length() <= SSO_CAPACITY) {
+			std::memcpy(_storage.small.data, v.data(), v.length());
+			_storage.small.size = (std::uint8_t)v.length();
+			_heap_string = false;
+		}
+		else {
+			_storage.heap.data = new char[v.length()];
+			std::memcpy(_storage.heap.data, v.data(), v.length());
+			_storage.heap.size = v.length();
+			_heap_string = true;
+		}
+		_type = value_type::V_STRING;
+	}
+
+	void value::move_from(value& other) noexcept {
+		_type = other._type;
+		_heap_string = other._heap_string;
+		if (other._type == value_type::V_ARRAY) {
+			new (&_storage.array) array_type(std::move(other._storage.array));
+			other.release();
+		}
+		else {
+			// heap strings and typed arrays change owner with the pointer copy
+			std::memcpy(static_cast<void*>(&_storage), &other._storage, sizeof(storage));
+			other._type = value_type::V_NULL;
+			other._heap_string = false;
+		}
+	}
+
+	void value::release() noexcept {
+		if (_type == value_type::V_ARRAY) {
+			_storage.array.~array_type();
+		}
+		else if (_type == value_type::V_TYPED_ARRAY) {
+			delete _storage.typed;
+		}
+		else if (_type == value_type::V_STRING and _heap_string) {
+			delete[] _storage.heap.data;
+		}
+		_type = value_type::V_NULL;
+		_heap_string = false;
+	}
+
+	void value::invalid_type(value_type expected) const {
+		throw std::invalid_argument(build_type_error_message(_type, expected));
+	}
+
+
+	typed_item to_typed_item(const value& v) {
+		auto item = typed_item();
+		switch (v.type()) {
+		case value_type::V_BOOL:
+			item.boolean = v.as_bool();
+			break;
+		case value_type::V_INT:
+			item.integer = v.as_int();
+			break;
+		case value_type::V_DOUBLE:
+			item.real = v.as_double();
+			break;
+		case value_type::V_STRING:
+			item.string = v.as_string();
+			break;
+		case value_type::V_TYPED_ARRAY:
+			item.array = &v.as_typed_array();
+			break;
+		default:
+			return item;
+		}
+		item.type = v.type();
+		return item;
+	}
+
+	typed_item to_typed_item(const std::any& v) {
+		auto item = typed_item();
+		if (v.type() == typeid(bool)) {
+			item.boolean = std::any_cast<bool>(v);
+			item.type = value_type::V_BOOL;
+		}
+		else if (v.type() == typeid(long long)) {
+			item.integer = std::any_cast<long long>(v);
+			item.type = value_type::V_INT;
+		}
+		else if (v.type() == typeid(double)) {
+			item.real = std::any_cast<double>(v);
+			item.type = value_type::V_DOUBLE;
+		}
+		else if (v.type() == typeid(std::string)) {
+			item.string = *std::any_cast<std::string>(&v);
+			item.type = value_type::V_STRING;
+		}
+		else if (v.type() == typeid(typed_array)) {
+			item.array = std::any_cast<typed_array>(&v);
+			item.type = value_type::V_TYPED_ARRAY;
+		}
+		return item;
+	}
+
+	typed_array::typed_array(const typed_array& other)
+		: _type(other._type), _shape(other._shape), _ints(other._ints), _doubles(other._doubles), _strings(other._strings) {
+		if (other._bools) {
+			auto count = other.size();
+			_bools = std::make_unique<bool[]>(count);
+			std::copy(other._bools.get(), other._bools.get() + count, _bools.get());
+		}
+	}
+
+	typed_array& typed_array::operator=(const typed_array& other) {
+		if (this != &other) {
+			*this = typed_array(other);
+		}
+		return *this;
+	}
+
+	bool typed_array::pack(std::span<const typed_item> items, typed_array& out) {
+		if (items.empty()) {
+			return false;
+		}
+
+		// every item must have the type and shape of the first one
+		auto& first = items[0];
+		auto type = first.type;
+		auto item_shape = std::span<const std::size_t>();
+		if (first.type == value_type::V_TYPED_ARRAY) {
+			type = first.array->_type;
+			item_shape = first.array->_shape;
+		}
+		else if (first.type != value_type::V_BOOL and first.type != value_type::V_INT
+			and first.type != value_type::V_DOUBLE and first.type != value_type::V_STRING) {
+			return false;
+		}
+		for (auto& item : items) {
+			if (item.type != first.type) {
+				return false;
+			}
+			if (item.type == value_type::V_TYPED_ARRAY and (item.array->_type != type
+				or !std::equal(item_shape.begin(), item_shape.end(), item.array->_shape.begin(), item.array->_shape.end()))) {
+				return false;
+			}
+		}
+
+		auto packed = typed_array();
+		packed._type = type;
+		packed._shape.reserve(item_shape.size() + 1);
+		packed._shape.push_back(items.size());
+		packed._shape.insert(packed._shape.end(), item_shape.begin(), item_shape.end());
+		auto count = packed.size();
+		auto item_count = count / items.size();
+
+		switch (type) {
+		case value_type::V_BOOL: {
+			packed._bools = std::make_unique<bool[]>(count);
+			auto out_item = packed._bools.get();
+			for (auto& item : items) {
+				if (item.array != nullptr) {
+					out_item = std::copy(item.array->_bools.get(), item.array->_bools.get() + item_count, out_item);
+				}
+				else {
+					*out_item++ = item.boolean;
+				}
+			}
+			break;
+		}
+		case value_type::V_INT:
+			packed._ints.reserve(count);
+			for (auto& item : items) {
+				if (item.array != nullptr) {
+					packed._ints.insert(packed._ints.end(), item.array->_ints.begin(), item.array->_ints.end());
+				}
+				else {
+					packed._ints.push_back(item.integer);
+				}
+			}
+			break;
+		case value_type::V_DOUBLE:
+			packed._doubles.reserve(count);
+			for (auto& item : items) {
+				if (item.array != nullptr) {
+					packed._doubles.insert(packed._doubles.end(), item.array->_doubles.begin(), item.array->_doubles.end());
+				}
+				else {
+					packed._doubles.push_back(item.real);
+				}
+			}
+			break;
+		default:
+			packed._strings.reserve(count);
+			for (auto& item : items) {
+				if (item.array != nullptr) {
+					packed._strings.insert(packed._strings.end(), item.array->_strings.begin(), item.array->_strings.end());
+				}
+				else {
+					packed._strings.emplace_back(item.string);
+				}
+			}
+		}
+
+		out = std::move(packed);
+		return true;
+	}
+
+	value_type typed_array::type() const noexcept {
+		return _type;
+	}
+
+	std::span<const std::size_t> typed_array::shape() const noexcept {
+		return _shape;
+	}
+
+	std::size_t typed_array::size() const {
+		if (_shape.empty()) {
+			return 0;
+		}
+		auto count = std::size_t(1);
+		for (auto length : _shape) {
+			count *= length;
+		}
+		return count;
+	}
+
+	template<>
+	std::span<const bool> typed_array::as_span<bool>() const {
+		check_type(value_type::V_BOOL);
+		return std::span<const bool>(_bools.get(), size());
+	}
+
+	template<>
+	std::span<const std::int64_t> typed_array::as_span<std::int64_t>() const {
+		check_type(value_type::V_INT);
+		return _ints;
+	}
+
+	template<>
+	std::span<const double> typed_array::as_span<double>() const {
+		check_type(value_type::V_DOUBLE);
+		return _doubles;
+	}
+
+	template<>
+	std::span<const std::string> typed_array::as_span<std::string>() const {
+		check_type(value_type::V_STRING);
+		return _strings;
+	}
+
+	value typed_array::item(std::size_t index) const {
+		if (index >= size()) {
+			throw std::out_of_range("Typed array index out of range.");
+		}
+		switch (_type) {
+		case value_type::V_BOOL:
+			return value(_bools[index]);
+		case value_type::V_INT:
+			return value((long long)_ints[index]);
+		case value_type::V_DOUBLE:
+			return value(_doubles[index]);
+		default:
+			return value(_strings[index]);
+		}
+	}
+
+	value::array_type typed_array::to_array() const {
+		auto arr = value::array_type();
+		auto index = std::size_t(0);
+		if (!_shape.empty()) {
+			to_array(0, index, arr);
+		}
+		return arr;
+	}
+
+	void typed_array::to_array(std::size_t dimension, std::size_t& index, value::array_type& arr) const {
+		arr.reserve(_shape[dimension]);
+		for (auto i = std::size_t(0); i < _shape[dimension]; ++i) {
+			if (dimension + 1 < _shape.size()) {
+				auto inner = value::array_type();
+				to_array(dimension + 1, index, inner);
+				arr.emplace_back(std::move(inner));
+			}
+			else {
+				arr.push_back(item(index++));
+			}
+		}
+	}
+
+	bool typed_array::operator==(const typed_array& other) const {
+		if (_type != other._type or _shape != other._shape) {
+			return false;
+		}
+		if (_type == value_type::V_BOOL) {
+			return std::equal(_bools.get(), _bools.get() + size(), other._bools.get());
+		}
+		return _ints == other._ints and _doubles == other._doubles and _strings == other._strings;
+	}
+
+	void typed_array::check_type(value_type expected) const {
+		if (_type != expected) {
+			throw std::invalid_argument(build_type_error_message(_type, expected));
+		}
+	}
+
+}
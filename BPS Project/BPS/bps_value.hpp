@@ -0,0 +1,206 @@
+#pragma once
+
+#include "pch.h"
+
+
+namespace bps_core {
+
+	enum value_type : std::uint8_t {
+		V_NULL = 0,
+		V_BOOL = 1,
+		V_CHAR = 2,
+		V_INT = 3,
+		V_FLOAT = 4,
+		V_DOUBLE = 5,
+		V_STRING = 6,
+		V_ARRAY = 7,
+		V_TYPED_ARRAY = 8
+	};
+
+	class typed_array;
+
+	std::string build_type_error_message(value_type, value_type);
+
+	// tagged union holding any BPS value, strings up to SSO_CAPACITY chars are stored inline. Floats are
+	// held as float or double at most: a long double, which the parser reads floats as by default, is
+	// narrowed to double, since holding it would make every value half as large again
+	class value {
+	public:
+		using array_type = std::vector<value>;
+
+		static constexpr std::size_t SSO_CAPACITY = 22;
+
+	private:
+		struct small_string {
+			char data[SSO_CAPACITY];
+			std::uint8_t size;
+		};
+
+		struct heap_string {
+			char* data;
+			std::size_t size;
+		};
+
+		union storage {
+			bool boolean;
+			char character;
+			std::int64_t integer;
+			float single;
+			double real;
+			small_string small;
+			heap_string heap;
+			array_type array;
+			typed_array* typed;
+
+			storage() noexcept {}
+			~storage() {}
+		};
+
+		storage _storage;
+		value_type _type;
+		bool _heap_string;
+
+	public:
+		value() noexcept;
+		value(std::nullptr_t) noexcept;
+		value(bool) noexcept;
+		value(char) noexcept;
+		value(int) noexcept;
+		value(long) noexcept;
+		value(long long) noexcept;
+		value(float) noexcept;
+		value(double) noexcept;
+		value(const char*);
+		value(std::string_view);
+		value(const std::string&);
+		value(array_type);
+		value(typed_array);
+
+		value(const value&);
+		value(value&&) noexcept;
+		value& operator=(const value&);
+		value& operator=(value&&) noexcept;
+		~value();
+
+		value_type type() const noexcept;
+
+		bool is_null() const noexcept;
+		bool as_bool() const;
+		char as_char() const;
+		std::int64_t as_int() const;
+		float as_float() const;
+		double as_double() const;
+		std::string_view as_string() const;
+		const array_type& as_array() const;
+		array_type& as_array();
+		const typed_array& as_typed_array() const;
+
+		// calls visitor with the held value, nullptr for null values
+		template<class Visitor>
+		decltype(auto) visit(Visitor&& visitor) const {
+			switch (_type) {
+			case value_type::V_BOOL:
+				return visitor(_storage.boolean);
+			case value_type::V_CHAR:
+				return visitor(_storage.character);
+			case value_type::V_INT:
+				return visitor(_storage.integer);
+			case value_type::V_FLOAT:
+				return visitor(_storage.single);
+			case value_type::V_DOUBLE:
+				return visitor(_storage.real);
+			case value_type::V_STRING:
+				return visitor(as_string());
+			case value_type::V_ARRAY:
+				return visitor(_storage.array);
+			case value_type::V_TYPED_ARRAY:
+				return visitor(*_storage.typed);
+			default:
+				return visitor(nullptr);
+			}
+		}
+
+		std::any to_any() const;
+		static value from_any(const std::any&);
+
+		bool operator==(const value&) const;
+
+	private:
+		void set_string(std::string_view);
+		void move_from(value&) noexcept;
+		void release() noexcept;
+		[[noreturn]] void invalid_type(value_type) const;
+	};
+
+
+	// item of an array being packed into a typed_array, its type is V_NULL when it can not be packed
+	struct typed_item {
+		value_type type = value_type::V_NULL;
+		bool boolean = false;
+		std::int64_t integer = 0;
+		double real = 0;
+		std::string_view string;
+		const typed_array* array = nullptr;
+	};
+
+	typed_item to_typed_item(const value&);
+	typed_item to_typed_item(const std::any&);
+
+	// array whose items are all bools, all integers, all doubles or all strings, stored in one
+	// contiguous buffer. Nested arrays of equal shape are stored as a single array with a shape,
+	// their items in row major order
+	class typed_array {
+	private:
+		// V_BOOL, V_INT, V_DOUBLE or V_STRING
+		value_type _type = value_type::V_NULL;
+		// length of each dimension, the outermost first
+		std::vector<std::size_t> _shape;
+
+		// only the buffer of the item type is used
+		std::unique_ptr<bool[]> _bools;
+		std::vector<std::int64_t> _ints;
+		std::vector<double> _doubles;
+		std::vector<std::string> _strings;
+
+	public:
+		typed_array() = default;
+		typed_array(const typed_array&);
+		typed_array(typed_array&&) noexcept = default;
+		typed_array& operator=(const typed_array&);
+		typed_array& operator=(typed_array&&) noexcept = default;
+
+		// packs the items if they are all scalars of one type, or all typed arrays of one type and
+		// shape, returns false and leaves out untouched otherwise
+		static bool pack(std::span<const typed_item>, typed_array&);
+
+		value_type type() const noexcept;
+		std::span<const std::size_t> shape() const noexcept;
+		// item count over every dimension
+		std::size_t size() const;
+
+		// items in row major order, T is bool, std::int64_t, double or std::string
+		template<class T>
+		std::span<const T> as_span() const;
+
+		// item at a row major index
+		value item(std::size_t) const;
+		// the same array as nested values
+		value::array_type to_array() const;
+
+		bool operator==(const typed_array&) const;
+
+	private:
+		void to_array(std::size_t, std::size_t&, value::array_type&) const;
+		void check_type(value_type) const;
+	};
+
+	template<>
+	std::span<const bool> typed_array::as_span<bool>() const;
+	template<>
+	std::span<const std::int64_t> typed_array::as_span<std::int64_t>() const;
+	template<>
+	std::span<const double> typed_array::as_span<double>() const;
+	template<>
+	std::span<const std::string> typed_array::as_span<std::string>() const;
+
+}
@@ -0,0 +1,283 @@
+#include "pch.h"
+#include "bps_writer.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bps_core {
+
+	void sink::flush() {
+	}
+
+
+	ostream_sink::ostream_sink(std::ostream& stream)
+		: _stream(stream) {
+	}
+
+	void ostream_sink::write(std::string_view chars) {
+		_stream.write(chars.data(), (std::streamsize)chars.length());
+		if (!_stream) {
+			throw std::runtime_error("Could not write to the stream.");
+		}
+	}
+
+	void ostream_sink::flush() {
+		_stream.flush();
+	}
+
+
+	callback_sink::callback_sink(std::function<void(std::string_view)> callback)
+		: _callback(std::move(callback)) {
+	}
+
+	void callback_sink::write(std::string_view chars) {
+		_callback(chars);
+	}
+
+
+	file_sink::file_sink(const std::filesystem::path& path)
+		: _path(path) {
+#ifdef _WIN32
+		auto file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			error("Could not open file", (int)GetLastError());
+		}
+		_file = file;
+#else
+		_file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (_file < 0) {
+			error("Could not open file", errno);
+		}
+#endif
+	}
+
+	file_sink::~file_sink() {
+		close();
+	}
+
+	void file_sink::write(std::string_view chars) {
+		// a write may take only part of the chars, the rest is written again
+		while (!chars.empty()) {
+#ifdef _WIN32
+			auto length = (DWORD)std::min<std::size_t>(chars.length(), 1u << 30);
+			DWORD written = 0;
+			if (!WriteFile(_file, chars.data(), length, &written, nullptr)) {
+				error("Could not write file", (int)GetLastError());
+			}
+#else
+			auto written = ::write(_file, chars.data(), chars.length());
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				error("Could not write file", errno);
+			}
+#endif
+			chars.remove_prefix((std::size_t)written);
+		}
+	}
+
+	void file_sink::close() noexcept {
+#ifdef _WIN32
+		if (_file != nullptr) {
+			CloseHandle(_file);
+			_file = nullptr;
+		}
+#else
+		if (_file >= 0) {
+			::close(_file);
+			_file = -1;
+		}
+#endif
+	}
+
+	void file_sink::error(std::string problem, int code) const {
+		std::stringstream msg;
+		msg << problem;
+		msg << " '";
+		msg << _path.string();
+		msg << "'";
+#ifdef _WIN32
+		throw std::system_error(code, std::system_category(), msg.str());
+#else
+		throw std::system_error(code, std::generic_category(), msg.str());
+#endif
+	}
+
+
+	writer::writer(sink& sink, std::size_t buffer_size)
+		: _sink(sink), _buffer_size(std::max<std::size_t>(buffer_size, 1)) {
+		_buffer.reserve(_buffer_size);
+	}
+
+	writer::~writer() {
+		try {
+			flush();
+		}
+		catch (...) {
+		}
+	}
+
+	void writer::separate() {
+		if (!_keyed) {
+			throw std::logic_error("A value must follow a key.");
+		}
+		if (_depth > 0 and !_first) {
+			_buffer += ',';
+		}
+		_first = false;
+	}
+
+	void writer::end_value() {
+		if (_depth == 0) {
+			_buffer += ";\n";
+			_keyed = false;
+		}
+		// checked after every value, so long arrays are flushed while they are written too
+		if (_buffer.length() >= _buffer_size) {
+			write_buffer();
+		}
+	}
+
+	void writer::write_buffer() {
+		_sink.write(_buffer);
+		_flushed += _buffer.length();
+		_buffer.clear();
+	}
+
+	writer& writer::key(std::string_view k) {
+		if (_keyed) {
+			throw std::logic_error("A key must start a statement.");
+		}
+
+		// the key must read back as a single key token
+		auto tok = token_view();
+		_lexer.load(k);
+		_lexer.next_token(tok);
+		if (tok.category != token_category::T_KEY or tok.length != k.length()) {
+			std::stringstream msg;
+			msg << "Invalid key '";
+			msg << k;
+			msg << "'.";
+			throw std::invalid_argument(msg.str());
+		}
+
+		_buffer += k;
+		_buffer += ':';
+		_keyed = true;
+		return *this;
+	}
+
+	writer& writer::value(std::nullptr_t) {
+		separate();
+		_buffer += "null";
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(bool v) {
+		separate();
+		_buffer += v ? "true" : "false";
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(char v) {
+		separate();
+		write_char(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(long long v) {
+		separate();
+		write_number(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(float v) {
+		separate();
+		write_number(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(double v) {
+		separate();
+		write_number(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(long double v) {
+		separate();
+		write_number(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(std::string_view v) {
+		separate();
+		write_string(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(const char* v) {
+		return value(std::string_view(v));
+	}
+
+	writer& writer::value(const std::string& v) {
+		return value(std::string_view(v));
+	}
+
+	writer& writer::value(const std::any& v) {
+		separate();
+		_plain.write_value(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::value(const bps_core::value& v) {
+		separate();
+		_plain.write_value(v, _buffer);
+		end_value();
+		return *this;
+	}
+
+	writer& writer::begin_array() {
+		separate();
+		_buffer += '[';
+		++_depth;
+		_first = true;
+		return *this;
+	}
+
+	writer& writer::end_array() {
+		if (_depth == 0) {
+			throw std::logic_error("No array to end.");
+		}
+		_buffer += ']';
+		--_depth;
+		_first = false;
+		end_value();
+		return *this;
+	}
+
+	void writer::flush() {
+		if (!_buffer.empty()) {
+			write_buffer();
+		}
+		_sink.flush();
+	}
+
+	std::size_t writer::written() const noexcept {
+		return _flushed + _buffer.length();
+	}
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "pch.h"
+#include "bps_core.hpp"
+
+
+namespace bps_core {
+
+	// destination of the text of a writer, which gives it a buffered run of chars at a time
+	class sink {
+	public:
+		virtual ~sink() = default;
+
+		virtual void write(std::string_view) = 0;
+		// hands the chars written so far to the system, when the sink buffers them itself
+		virtual void flush();
+	};
+
+	class ostream_sink : public sink {
+	private:
+		std::ostream& _stream;
+
+	public:
+		explicit ostream_sink(std::ostream&);
+
+		void write(std::string_view) override;
+		void flush() override;
+	};
+
+	class callback_sink : public sink {
+	private:
+		std::function<void(std::string_view)> _callback;
+
+	public:
+		explicit callback_sink(std::function<void(std::string_view)>);
+
+		void write(std::string_view) override;
+	};
+
+	// writes straight to a file, created or truncated when opened, without buffering of its own
+	class file_sink : public sink {
+	private:
+#ifdef _WIN32
+		void* _file = nullptr;
+#else
+		int _file = -1;
+#endif
+		std::filesystem::path _path;
+
+		[[noreturn]] void error(std::string, int) const;
+
+	public:
+		explicit file_sink(const std::filesystem::path&);
+		file_sink(const file_sink&) = delete;
+		file_sink& operator=(const file_sink&) = delete;
+		~file_sink();
+
+		void write(std::string_view) override;
+		void close() noexcept;
+	};
+
+	// writes BPS plain text to a sink as it is produced, a statement at a time, without building a
+	// document first. Keys and values are formatted as plain formats them, and the text is buffered
+	// until it reaches the buffer size. Calls out of the BPS grammar throw std::logic_error
+	class writer {
+	private:
+		sink& _sink;
+		std::string _buffer;
+		std::size_t _buffer_size;
+		std::size_t _flushed = 0;
+
+		plain _plain;
+		lexer _lexer;
+
+		// array nesting depth, and whether the statement has its key and the array its first item
+		int _depth = 0;
+		bool _keyed = false;
+		bool _first = true;
+
+		// writes the ',' before an item, after checking the value has a key
+		void separate();
+		// ends the statement once its value is complete
+		void end_value();
+		void write_buffer();
+
+	public:
+		static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+		explicit writer(sink&, std::size_t = DEFAULT_BUFFER_SIZE);
+		writer(const writer&) = delete;
+		writer& operator=(const writer&) = delete;
+		// flushes what is still buffered, errors of the sink are lost, flush first to get them
+		~writer();
+
+		writer& key(std::string_view);
+
+		writer& value(std::nullptr_t);
+		writer& value(bool);
+		writer& value(char);
+		writer& value(long long);
+		writer& value(float);
+		writer& value(double);
+		writer& value(long double);
+		writer& value(std::string_view);
+		writer& value(const char*);
+		writer& value(const std::string&);
+		writer& value(const std::any&);
+		writer& value(const bps_core::value&);
+
+		// other integer types are written as long long
+		template<std::integral T>
+		writer& value(T);
+
+		writer& begin_array();
+		writer& end_array();
+
+		// gives the buffered text to the sink and flushes it
+		void flush();
+
+		// number of chars written, buffered ones included
+		std::size_t written() const noexcept;
+	};
+
+	template<std::integral T>
+	writer& writer::value(T v) {
+		return value((long long)v);
+	}
+
+}
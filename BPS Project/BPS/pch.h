@@ -3,13 +3,38 @@
 
 #include <iostream>
 #include <map>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <bit>
+#include <charconv>
 #include <any>
 #include <vector>
+#include <array>
+#include <tuple>
 #include <stack>
+#include <deque>
 #include <typeinfo>
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
 #include <regex>
+#include <span>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <functional>
+#include <chrono>
+#include <concepts>
+#include <utility>
+#include <filesystem>
+#include <system_error>
 
 #endif //PCH_H